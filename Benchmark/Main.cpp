@@ -0,0 +1,809 @@
+/*
+  ==============================================================================
+
+    Micro-benchmarks for the compressor and envelope detector kernels.
+
+    Every combination of sample type, sample rate, block size, channel count,
+    level calculation type, RC mode, precision and signal level is timed and
+    written as one CSV or JSON record, so that runs can be compared between
+    releases. The fixed point engine is timed on 16, 24 and 32 bit PCM with
+    the same settings, for a comparison with the float engines.
+
+    With --verify nothing is timed: the output of the fixed point engine is
+    compared with that of MyCompressor<double> instead, and the exit code is
+    1 if it strays further than the bounds given in main(). The float engines
+    are also run with every instruction set the CPU supports, and the exit
+    code is 1 if any of them differs from the generic kernels in a single bit.
+    Finally the fast gain computer is swept against the exact one and must
+    stay within 0.0005 dB of it.
+
+  ==============================================================================
+*/
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <JuceHeader.h>
+#include "../Source/MyCompressor.h"
+#include "../Source/MyMultibandCompressor.h"
+#include "../Source/MyCompressorBank.h"
+#include "../Source/MyFixedPointCompressor.h"
+
+//==============================================================================
+struct BenchmarkOptions
+{
+    std::vector<size_t> blockSizes{ 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+    std::vector<size_t> channelCounts{ 1, 2, 4, 8, 16 };
+    std::vector<size_t> sampleRates{ 48000 };
+    size_t numFrames = 16384;   // frames processed per timed pass
+    int numPasses = 5;          // the fastest pass is reported
+    bool verify = false;
+    std::string csvFile, jsonFile;
+};
+
+struct BenchmarkResult
+{
+    std::string kernel, sampleType, levelType, precision, signal, instructionSet;
+    size_t sampleRate = 0, blockSize = 0, numChannels = 0;
+    int rcMode = 0;
+    double nsPerSample = 0.0, samplesPerSecond = 0.0;
+};
+
+static const char* levelTypeNames[] = { "peak", "RMS", "windowedRMS" };
+static const char* precisionNames[] = { "exact", "fast" };
+static const char* linkModeNames[] = { "none", "max", "mean", "weighted" };
+
+//==============================================================================
+/** Fills a buffer with a sine wave. The "above" signal sits at -6 dBFS, 14 dB
+    over the benchmark threshold, the "below" signal at -40 dBFS.
+*/
+template <typename SampleType>
+static void fillSignal(std::vector<std::vector<SampleType>>& channels, bool aboveThreshold)
+{
+    const auto amplitude = aboveThreshold ? 0.5 : 0.01;
+
+    for (size_t channel = 0; channel < channels.size(); ++channel)
+        for (size_t i = 0; i < channels[channel].size(); ++i)
+            channels[channel][i] = static_cast<SampleType> (amplitude * std::sin(0.13 * (double)i + (double)channel));
+}
+
+/** Runs process() over the whole signal in blocks and returns the fastest pass
+    in nanoseconds.
+*/
+template <typename Processor, typename SampleType>
+static double timeProcessor(Processor& processor, const BenchmarkOptions& options, size_t blockSize,
+                            std::vector<std::vector<SampleType>>& input, std::vector<std::vector<SampleType>>& output)
+{
+    const auto numChannels = input.size();
+
+    std::vector<const SampleType*> inputPointers;
+    std::vector<SampleType*> outputPointers;
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        inputPointers.push_back(input[channel].data());
+        outputPointers.push_back(output[channel].data());
+    }
+
+    auto best = std::numeric_limits<double>::max();
+
+    // The first pass warms up caches and the envelope and is not counted
+    for (int pass = 0; pass <= options.numPasses; ++pass)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t position = 0; position < options.numFrames; position += blockSize)
+        {
+            const auto numSamples = juce::jmin(blockSize, options.numFrames - position);
+
+            auto in = juce::dsp::AudioBlock<const SampleType>(inputPointers.data(), numChannels, options.numFrames).getSubBlock(position, numSamples);
+            auto out = juce::dsp::AudioBlock<SampleType>(outputPointers.data(), numChannels, options.numFrames).getSubBlock(position, numSamples);
+
+            processor.process(juce::dsp::ProcessContextNonReplacing<SampleType>(in, out));
+        }
+
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        if (pass > 0)
+            best = juce::jmin(best, elapsed);
+    }
+
+    return best;
+}
+
+template <typename SampleType>
+static void runBenchmarks(const BenchmarkOptions& options, std::vector<BenchmarkResult>& results)
+{
+    const auto* sampleTypeName = std::is_same_v<SampleType, float> ? "float" : "double";
+
+    for (auto rate : options.sampleRates)
+    {
+        const auto sampleRate = (double)rate;
+
+        for (auto numChannels : options.channelCounts)
+        {
+            std::vector<std::vector<SampleType>> input(numChannels, std::vector<SampleType>(options.numFrames));
+            auto output = input;
+
+            for (auto aboveThreshold : { true, false })
+            {
+                fillSignal(input, aboveThreshold);
+
+                for (auto blockSize : options.blockSizes)
+                {
+                    const juce::dsp::ProcessSpec spec{ sampleRate, (juce::uint32)blockSize, (juce::uint32)numChannels };
+
+                    for (int level = 0; level < 3; ++level)
+                    {
+                        const auto levelType = static_cast<BallisticsFilterLevelCalculationType>(level);
+
+                        for (int rcMode = 0; rcMode < 3; ++rcMode)
+                        {
+                            auto addResult = [&](const char* kernel, const char* precisionName, double nanoseconds)
+                            {
+                                BenchmarkResult r;
+                                r.kernel = kernel;
+                                r.sampleType = sampleTypeName;
+                                r.levelType = levelTypeNames[level];
+                                r.precision = precisionName;
+                                r.signal = aboveThreshold ? "above" : "below";
+                                r.sampleRate = rate;
+                                r.blockSize = blockSize;
+                                r.numChannels = numChannels;
+                                r.rcMode = rcMode;
+                                r.nsPerSample = nanoseconds / (double)(options.numFrames * numChannels);
+                                r.samplesPerSecond = 1.0e9 / r.nsPerSample;
+                                results.push_back(r);
+                            };
+
+                            MyEnvelopeDetector<SampleType> detector;
+                            detector.setAttackTime(5);
+                            detector.setReleaseTime(200);
+                            detector.setLevelCalculationType(levelType);
+                            detector.prepare(spec);
+                            detector.setTC(rcMode);
+
+                            addResult("detector", "-", timeProcessor(detector, options, blockSize, input, output));
+
+                            for (int precision = 0; precision < 2; ++precision)
+                            {
+                                MyCompressor<SampleType> compressor;
+                                compressor.prepare(spec);
+                                compressor.setLevelCalculationType(levelType);
+                                compressor.setPrecision(static_cast<GainComputerPrecision>(precision));
+
+                                MyCompressorParameters parameters;
+                                parameters.thresholddB = -20.0;
+                                parameters.ratio = 4.0;
+                                parameters.attackTime = 5.0;
+                                parameters.releaseTime = 200.0;
+                                parameters.rcMode = rcMode;
+                                compressor.setCoefficients(MyCompressorCoefficients::calculate(parameters, sampleRate));
+
+                                addResult("compressor", precisionNames[precision], timeProcessor(compressor, options, blockSize, input, output));
+
+                                // The control rate mode, where the sample rate allows it
+                                parameters.controlRate = true;
+                                const auto controlRateCoefficients = MyCompressorCoefficients::calculate(parameters, sampleRate);
+                                parameters.controlRate = false;
+
+                                if (controlRateCoefficients.controlRateFactor > 1)
+                                {
+                                    compressor.setCoefficients(controlRateCoefficients);
+                                    compressor.reset();
+                                    addResult("compressorControlRate", precisionNames[precision], timeProcessor(compressor, options, blockSize, input, output));
+                                }
+
+                                // Four bands with the same settings, including the crossover
+                                MyMultibandCompressor<SampleType> multiband;
+                                multiband.prepare(spec);
+                                multiband.setLevelCalculationType(levelType);
+                                multiband.setPrecision(static_cast<GainComputerPrecision>(precision));
+
+                                MyMultibandCoefficients multibandCoefficients;
+                                multibandCoefficients.numBands = 4;
+                                multibandCoefficients.bands.fill(MyCompressorCoefficients::calculate(parameters, sampleRate));
+                                multiband.setCoefficients(multibandCoefficients);
+
+                                addResult("multiband4", precisionNames[precision], timeProcessor(multiband, options, blockSize, input, output));
+
+                                // Independent mono channels; the bank has no windowed RMS detector
+                                if (levelType != BallisticsFilterLevelCalculationType::windowedRMS)
+                                {
+                                    MyCompressorBank<SampleType> bank;
+                                    bank.prepare(spec);
+                                    bank.setLevelCalculationType(levelType);
+                                    bank.setPrecision(static_cast<GainComputerPrecision>(precision));
+                                    bank.setCoefficients(MyCompressorCoefficients::calculate(parameters, sampleRate));
+
+                                    addResult("bank", precisionNames[precision], timeProcessor(bank, options, blockSize, input, output));
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+//==============================================================================
+/** The same signals as fillSignal(), as PCM samples. */
+template <typename PCMType>
+static void fillPCMSignal(std::vector<std::vector<PCMType>>& channels, bool aboveThreshold)
+{
+    const auto amplitude = (aboveThreshold ? 0.5 : 0.01) * std::ldexp(1.0, MyPCMFormat<PCMType>::numBits - 1);
+
+    for (size_t channel = 0; channel < channels.size(); ++channel)
+        for (size_t i = 0; i < channels[channel].size(); ++i)
+            MyPCMFormat<PCMType>::write(channels[channel][i], std::llround(amplitude * std::sin(0.13 * (double)i + (double)channel)));
+}
+
+/** timeProcessor() for MyFixedPointCompressor, which takes PCM channel pointers. */
+template <typename PCMType>
+static double timeFixedPoint(MyFixedPointCompressor& compressor, const BenchmarkOptions& options, size_t blockSize,
+                             std::vector<std::vector<PCMType>>& input, std::vector<std::vector<PCMType>>& output)
+{
+    const auto numChannels = input.size();
+
+    std::vector<const PCMType*> inputPointers(numChannels);
+    std::vector<PCMType*> outputPointers(numChannels);
+
+    auto best = std::numeric_limits<double>::max();
+
+    for (int pass = 0; pass <= options.numPasses; ++pass)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t position = 0; position < options.numFrames; position += blockSize)
+        {
+            const auto numSamples = juce::jmin(blockSize, options.numFrames - position);
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+            {
+                inputPointers[channel] = input[channel].data() + position;
+                outputPointers[channel] = output[channel].data() + position;
+            }
+
+            compressor.process(inputPointers.data(), outputPointers.data(), numSamples);
+        }
+
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        if (pass > 0)
+            best = juce::jmin(best, elapsed);
+    }
+
+    return best;
+}
+
+template <typename PCMType>
+static void runFixedPointBenchmarks(const BenchmarkOptions& options, const char* sampleTypeName, std::vector<BenchmarkResult>& results)
+{
+    for (auto rate : options.sampleRates)
+    {
+        const auto sampleRate = (double)rate;
+
+        for (auto numChannels : options.channelCounts)
+        {
+            std::vector<std::vector<PCMType>> input(numChannels, std::vector<PCMType>(options.numFrames));
+            auto output = input;
+
+            for (auto aboveThreshold : { true, false })
+            {
+                fillPCMSignal(input, aboveThreshold);
+
+                for (auto blockSize : options.blockSizes)
+                {
+                    const juce::dsp::ProcessSpec spec{ sampleRate, (juce::uint32)blockSize, (juce::uint32)numChannels };
+
+                    // There is no windowed RMS detector
+                    for (int level = 0; level < 2; ++level)
+                    {
+                        for (int rcMode = 0; rcMode < 3; ++rcMode)
+                        {
+                            MyFixedPointCompressor compressor;
+                            compressor.prepare(spec);
+                            compressor.setLevelCalculationType(static_cast<BallisticsFilterLevelCalculationType>(level));
+
+                            MyCompressorParameters parameters;
+                            parameters.thresholddB = -20.0;
+                            parameters.ratio = 4.0;
+                            parameters.attackTime = 5.0;
+                            parameters.releaseTime = 200.0;
+                            parameters.rcMode = rcMode;
+                            compressor.setCoefficients(MyCompressorCoefficients::calculate(parameters, sampleRate));
+
+                            BenchmarkResult r;
+                            r.kernel = "fixedPoint";
+                            r.sampleType = sampleTypeName;
+                            r.levelType = levelTypeNames[level];
+                            r.precision = "-";
+                            r.signal = aboveThreshold ? "above" : "below";
+                            r.sampleRate = rate;
+                            r.blockSize = blockSize;
+                            r.numChannels = numChannels;
+                            r.rcMode = rcMode;
+                            r.nsPerSample = timeFixedPoint(compressor, options, blockSize, input, output) / (double)(options.numFrames * numChannels);
+                            r.samplesPerSecond = 1.0e9 / r.nsPerSample;
+                            results.push_back(r);
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+//==============================================================================
+/** Compresses bursts alternating between -1 and -34 dBFS every 250 ms with
+    the fixed point engine and with MyCompressor<double>, which gets the same
+    PCM values as input, and returns the signal to error ratio in dB and the
+    largest error in LSBs of the fixed point output.
+*/
+template <typename PCMType>
+static std::pair<double, double> compareFixedPoint(BallisticsFilterLevelCalculationType levelType, ChannelLinkMode linkMode, int rcMode)
+{
+    using Format = MyPCMFormat<PCMType>;
+
+    constexpr double sampleRate = 48000.0;
+    constexpr size_t numChannels = 2, numFrames = 96000, blockSize = 480;
+    const auto fullScale = std::ldexp(1.0, Format::numBits - 1);
+
+    std::vector<std::vector<PCMType>> input(numChannels, std::vector<PCMType>(numFrames)), output(input);
+    std::vector<std::vector<double>> reference(numChannels, std::vector<double>(numFrames));
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            const auto t = (double)i / sampleRate;
+            const auto amplitude = (i / 12000) % 2 != 0 ? 0.9 : 0.02;
+            const auto x = amplitude * (0.7 * std::sin(2.0 * juce::MathConstants<double>::pi * 440.0 * t + (double)channel)
+                                        + 0.3 * std::sin(2.0 * juce::MathConstants<double>::pi * 3137.0 * t));
+
+            Format::write(input[channel][i], std::llround(x * fullScale));
+            reference[channel][i] = (double)Format::read(input[channel][i]) / fullScale;
+        }
+    }
+
+    MyCompressorParameters parameters;
+    parameters.thresholddB = -20.0;
+    parameters.ratio = 4.0;
+    parameters.attackTime = 5.0;
+    parameters.releaseTime = 200.0;
+    parameters.rcMode = rcMode;
+
+    const auto coefficients = MyCompressorCoefficients::calculate(parameters, sampleRate);
+    const juce::dsp::ProcessSpec spec{ sampleRate, (juce::uint32)blockSize, (juce::uint32)numChannels };
+
+    MyFixedPointCompressor fixedPoint;
+    fixedPoint.prepare(spec);
+    fixedPoint.setLevelCalculationType(levelType);
+    fixedPoint.setLinkMode(linkMode);
+    fixedPoint.setCoefficients(coefficients);
+
+    MyCompressor<double> floatingPoint;
+    floatingPoint.prepare(spec);
+    floatingPoint.setLevelCalculationType(levelType);
+    floatingPoint.setLinkMode(linkMode);
+    floatingPoint.setCoefficients(coefficients);
+
+    std::array<const PCMType*, numChannels> inputPointers;
+    std::array<PCMType*, numChannels> outputPointers;
+    std::array<double*, numChannels> referencePointers;
+
+    for (size_t position = 0; position < numFrames; position += blockSize)
+    {
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            inputPointers[channel] = input[channel].data() + position;
+            outputPointers[channel] = output[channel].data() + position;
+            referencePointers[channel] = reference[channel].data() + position;
+        }
+
+        fixedPoint.process(inputPointers.data(), outputPointers.data(), blockSize);
+
+        juce::dsp::AudioBlock<double> block(referencePointers.data(), numChannels, blockSize);
+        floatingPoint.process(juce::dsp::ProcessContextReplacing<double>(block));
+    }
+
+    double signalEnergy = 0.0, errorEnergy = 0.0, maximumError = 0.0;
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            const auto expected = reference[channel][i] * fullScale;
+            const auto error = (double)Format::read(output[channel][i]) - expected;
+
+            signalEnergy += expected * expected;
+            errorEnergy += error * error;
+            maximumError = juce::jmax(maximumError, std::abs(error));
+        }
+    }
+
+    // Identical outputs count as an infinite ratio
+    const auto snr = errorEnergy > 0.0 ? 10.0 * std::log10(signalEnergy / errorEnergy) : std::numeric_limits<double>::infinity();
+    return { snr, maximumError };
+}
+
+/** Runs compareFixedPoint() for every level calculation type, link mode and
+    RC mode the fixed point engine supports, prints the results and returns
+    false if any of them falls below minimumSNR or exceeds maximumError.
+*/
+template <typename PCMType>
+static bool verifyFixedPoint(const char* sampleTypeName, double minimumSNR, double maximumError)
+{
+    auto passed = true;
+
+    for (int level = 0; level < 2; ++level)
+    {
+        for (auto linkMode : { ChannelLinkMode::none, ChannelLinkMode::max, ChannelLinkMode::mean })
+        {
+            for (int rcMode = 0; rcMode < 3; ++rcMode)
+            {
+                const auto [snr, error] = compareFixedPoint<PCMType>(static_cast<BallisticsFilterLevelCalculationType>(level), linkMode, rcMode);
+                const auto isWithinBounds = snr >= minimumSNR && error <= maximumError;
+
+                std::cout << sampleTypeName << ' ' << levelTypeNames[level] << ", link " << linkModeNames[(size_t)linkMode] << ", RC mode " << rcMode
+                          << ": SNR " << snr << " dB, max error " << error << " LSB" << (isWithinBounds ? "" : ", FAILED") << '\n';
+
+                passed = passed && isWithinBounds;
+            }
+        }
+    }
+
+    return passed;
+}
+
+//==============================================================================
+/** Compares the fast gain computer with the exact one (juce::Decibels) over
+    the threshold and ratio ranges of the plugin and levels from -120 to
+    +36 dBFS, for a peak and a mean square detector, and returns the largest
+    difference in dB.
+*/
+template <typename SampleType>
+static double measureFastGainError(bool isMeanSquare)
+{
+    const juce::dsp::ProcessSpec spec{ 48000.0, 64, 1 };
+
+    MyCompressor<SampleType> fast, exact;
+    fast.prepare(spec);
+    exact.prepare(spec);
+    fast.setPrecision(GainComputerPrecision::fast);
+    exact.setPrecision(GainComputerPrecision::exact);
+
+    auto maximumError = 0.0;
+
+    for (auto thresholddB = -60.0; thresholddB <= 12.0; thresholddB += 0.5)
+    {
+        // 33 ratios from 1 to 100, evenly spaced on a log scale
+        for (int step = 0; step <= 32; ++step)
+        {
+            MyCompressorParameters parameters;
+            parameters.thresholddB = thresholddB;
+            parameters.ratio = std::pow(100.0, step / 32.0);
+
+            const auto coefficients = MyCompressorCoefficients::calculate(parameters, spec.sampleRate);
+            fast.setCoefficients(coefficients);
+            exact.setCoefficients(coefficients);
+
+            // A step that is not a fraction of 6.02 dB, so the levels fall on
+            // every part of the polynomials' mantissa range
+            for (auto leveldB = -120.0; leveldB <= 36.0; leveldB += 0.0371)
+            {
+                const auto level = static_cast<SampleType> (juce::Decibels::decibelsToGain(leveldB, -300.0));
+                const auto error = std::abs(juce::Decibels::gainToDecibels((double)fast.computeStaticGain(level, isMeanSquare), -300.0)
+                                            - juce::Decibels::gainToDecibels((double)exact.computeStaticGain(level, isMeanSquare), -300.0));
+
+                maximumError = juce::jmax(maximumError, error);
+            }
+        }
+    }
+
+    return maximumError;
+}
+
+/** Runs measureFastGainError() for a peak and a mean square detector, prints
+    the results and returns false if either exceeds maximumErrordB.
+*/
+template <typename SampleType>
+static bool verifyFastGain(double maximumErrordB)
+{
+    const auto* sampleTypeName = std::is_same_v<SampleType, float> ? "float" : "double";
+    auto passed = true;
+
+    for (auto isMeanSquare : { false, true })
+    {
+        const auto error = measureFastGainError<SampleType>(isMeanSquare);
+        const auto isWithinBound = error <= maximumErrordB;
+
+        std::cout << sampleTypeName << " fast gain computer, " << (isMeanSquare ? "mean square" : "peak") << " level: max error "
+                  << error << " dB" << (isWithinBound ? "" : ", FAILED") << '\n';
+
+        passed = passed && isWithinBound;
+    }
+
+    return passed;
+}
+
+//==============================================================================
+/** Prepares a processor with setup() while getInstructionSet() returns the
+    given instruction set, compresses the same bursts as compareFixedPoint()
+    with it, at 96 kHz so that the control rate mode is used, and returns the
+    output.
+*/
+template <typename SampleType, typename Processor, typename Setup>
+static std::vector<std::vector<SampleType>> renderWithInstructionSet(InstructionSet instructionSet, size_t numChannels, Setup&& setup)
+{
+    constexpr double sampleRate = 96000.0;
+    constexpr size_t numFrames = 96000, blockSize = 437;
+
+    std::vector<std::vector<SampleType>> channels(numChannels, std::vector<SampleType>(numFrames));
+
+    for (size_t channel = 0; channel < numChannels; ++channel)
+    {
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            const auto t = (double)i / sampleRate;
+            const auto amplitude = (i / 24000) % 2 != 0 ? 0.9 : 0.02;
+            channels[channel][i] = static_cast<SampleType> (amplitude * (0.7 * std::sin(2.0 * juce::MathConstants<double>::pi * 440.0 * t + (double)channel)
+                                                                         + 0.3 * std::sin(2.0 * juce::MathConstants<double>::pi * 3137.0 * t)));
+        }
+    }
+
+    MyCpuDispatch::setOverride(instructionSet);
+
+    Processor processor;
+    setup(processor, juce::dsp::ProcessSpec{ sampleRate, (juce::uint32)blockSize, (juce::uint32)numChannels }, sampleRate);
+
+    std::vector<SampleType*> pointers(numChannels);
+
+    for (size_t position = 0; position < numFrames; position += blockSize)
+    {
+        const auto numSamples = juce::jmin(blockSize, numFrames - position);
+
+        for (size_t channel = 0; channel < numChannels; ++channel)
+            pointers[channel] = channels[channel].data() + position;
+
+        juce::dsp::AudioBlock<SampleType> block(pointers.data(), numChannels, numSamples);
+        processor.process(juce::dsp::ProcessContextReplacing<SampleType>(block));
+    }
+
+    return channels;
+}
+
+/** Runs renderWithInstructionSet() for every instruction set the CPU supports
+    and every setting setup() takes, prints how many settings gave an output
+    that differs in any bit from the generic kernels and returns false if
+    there were any.
+*/
+template <typename SampleType, typename Processor, typename Setup>
+static bool verifyInstructionSets(const char* processorName, size_t numChannels, int numSettings, Setup&& setup)
+{
+    const auto* sampleTypeName = std::is_same_v<SampleType, float> ? "float" : "double";
+    auto passed = true;
+
+    for (auto instructionSet : { InstructionSet::avx2, InstructionSet::avx512 })
+    {
+        if (! MyCpuDispatch::isSupported(instructionSet))
+            continue;
+
+        auto numDifferent = 0;
+
+        for (int setting = 0; setting < numSettings; ++setting)
+        {
+            auto setupSetting = [&](Processor& processor, const juce::dsp::ProcessSpec& spec, double sampleRate) { setup(processor, spec, sampleRate, setting); };
+
+            const auto expected = renderWithInstructionSet<SampleType, Processor>(InstructionSet::generic, numChannels, setupSetting);
+            const auto actual = renderWithInstructionSet<SampleType, Processor>(instructionSet, numChannels, setupSetting);
+
+            for (size_t channel = 0; channel < numChannels; ++channel)
+            {
+                if (std::memcmp(expected[channel].data(), actual[channel].data(), expected[channel].size() * sizeof(SampleType)) != 0)
+                {
+                    ++numDifferent;
+                    break;
+                }
+            }
+        }
+
+        std::cout << sampleTypeName << ' ' << processorName << ", " << MyCpuDispatch::getName(instructionSet) << ": "
+                  << numDifferent << " of " << numSettings << " settings differ from generic" << (numDifferent == 0 ? "" : ", FAILED") << '\n';
+
+        passed = passed && numDifferent == 0;
+    }
+
+    MyCpuDispatch::clearOverride();
+    return passed;
+}
+
+/** Checks that every instruction set gives bit-identical output, for every
+    level calculation type, precision, link mode, control rate, lookahead and
+    key filter of MyCompressor, and for MyCompressorBank and
+    MyMultibandCompressor.
+*/
+template <typename SampleType>
+static bool verifyAllInstructionSets()
+{
+    auto makeParameters = [](bool controlRate, bool lookahead, bool keyFilter)
+    {
+        MyCompressorParameters parameters;
+        parameters.thresholddB = -20.0;
+        parameters.ratio = 4.0;
+        parameters.attackTime = 5.0;
+        parameters.releaseTime = 200.0;
+        parameters.rmsWindowTime = 10.0;
+        parameters.controlRate = controlRate;
+        parameters.lookaheadTime = lookahead ? 5.0 : 0.0;
+        parameters.sidechainFilterType = keyFilter ? SidechainFilterType::highPass : SidechainFilterType::off;
+        return parameters;
+    };
+
+    // 3 channels, so that the last group of lanes is not full
+    auto passed = verifyInstructionSets<SampleType, MyCompressor<SampleType>>("compressor", 3, 3 * 2 * 4 * 8,
+        [&](MyCompressor<SampleType>& compressor, const juce::dsp::ProcessSpec& spec, double sampleRate, int setting)
+        {
+            compressor.prepare(spec);
+            compressor.setLevelCalculationType(static_cast<BallisticsFilterLevelCalculationType>(setting % 3));
+            compressor.setPrecision(static_cast<GainComputerPrecision>((setting / 3) % 2));
+            compressor.setLinkMode(static_cast<ChannelLinkMode>((setting / 6) % 4));
+            compressor.setLinkWeight(1, (SampleType)0.5);
+
+            const auto options = setting / 24;
+            compressor.setCoefficients(MyCompressorCoefficients::calculate(makeParameters((options & 1) != 0, (options & 2) != 0, (options & 4) != 0), sampleRate));
+        });
+
+    // The bank has no windowed RMS detector; 11 channels leave a partial group
+    passed = verifyInstructionSets<SampleType, MyCompressorBank<SampleType>>("bank", 11, 2 * 2,
+        [&](MyCompressorBank<SampleType>& bank, const juce::dsp::ProcessSpec& spec, double sampleRate, int setting)
+        {
+            bank.prepare(spec);
+            bank.setLevelCalculationType(static_cast<BallisticsFilterLevelCalculationType>(setting % 2));
+            bank.setPrecision(static_cast<GainComputerPrecision>(setting / 2));
+            bank.setCoefficients(MyCompressorCoefficients::calculate(makeParameters(false, false, false), sampleRate));
+        }) && passed;
+
+    passed = verifyInstructionSets<SampleType, MyMultibandCompressor<SampleType>>("multiband4", 2, 3 * 2,
+        [&](MyMultibandCompressor<SampleType>& multiband, const juce::dsp::ProcessSpec& spec, double sampleRate, int setting)
+        {
+            multiband.prepare(spec);
+            multiband.setLevelCalculationType(static_cast<BallisticsFilterLevelCalculationType>(setting % 3));
+            multiband.setPrecision(static_cast<GainComputerPrecision>(setting / 3));
+
+            MyMultibandCoefficients coefficients;
+            coefficients.numBands = 4;
+            coefficients.bands.fill(MyCompressorCoefficients::calculate(makeParameters(false, true, false), sampleRate));
+            multiband.setCoefficients(coefficients);
+        }) && passed;
+
+    return passed;
+}
+
+//==============================================================================
+static void writeCSV(std::ostream& stream, const std::vector<BenchmarkResult>& results)
+{
+    stream << "kernel,sampleType,sampleRate,blockSize,numChannels,levelType,rcMode,precision,signal,instructionSet,nsPerSample,samplesPerSecond\n";
+
+    for (auto& r : results)
+        stream << r.kernel << ',' << r.sampleType << ',' << r.sampleRate << ',' << r.blockSize << ',' << r.numChannels << ','
+               << r.levelType << ',' << r.rcMode << ',' << r.precision << ',' << r.signal << ',' << r.instructionSet << ','
+               << r.nsPerSample << ',' << r.samplesPerSecond << '\n';
+}
+
+static void writeJSON(std::ostream& stream, const std::vector<BenchmarkResult>& results)
+{
+    stream << "[\n";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto& r = results[i];
+        stream << "  { \"kernel\": \"" << r.kernel << "\", \"sampleType\": \"" << r.sampleType
+               << "\", \"sampleRate\": " << r.sampleRate << ", \"blockSize\": " << r.blockSize << ", \"numChannels\": " << r.numChannels
+               << ", \"levelType\": \"" << r.levelType << "\", \"rcMode\": " << r.rcMode
+               << ", \"precision\": \"" << r.precision << "\", \"signal\": \"" << r.signal << "\", \"instructionSet\": \"" << r.instructionSet
+               << "\", \"nsPerSample\": " << r.nsPerSample << ", \"samplesPerSecond\": " << r.samplesPerSecond
+               << (i + 1 < results.size() ? " },\n" : " }\n");
+    }
+
+    stream << "]\n";
+}
+
+static std::vector<size_t> parseList(const std::string& text)
+{
+    std::vector<size_t> values;
+    size_t start = 0;
+
+    while (start < text.size())
+    {
+        auto end = text.find(',', start);
+        values.push_back((size_t)std::stoul(text.substr(start, end - start)));
+        start = end == std::string::npos ? text.size() : end + 1;
+    }
+
+    return values;
+}
+
+int main(int argc, char* argv[])
+{
+    BenchmarkOptions options;
+    InstructionSet instructionSet;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        const auto hasValue = i + 1 < argc;
+
+        if (arg == "--csv" && hasValue)             options.csvFile = argv[++i];
+        else if (arg == "--json" && hasValue)       options.jsonFile = argv[++i];
+        else if (arg == "--blocks" && hasValue)     options.blockSizes = parseList(argv[++i]);
+        else if (arg == "--channels" && hasValue)   options.channelCounts = parseList(argv[++i]);
+        else if (arg == "--rates" && hasValue)      options.sampleRates = parseList(argv[++i]);
+        else if (arg == "--frames" && hasValue)     options.numFrames = (size_t)std::stoul(argv[++i]);
+        else if (arg == "--passes" && hasValue)     options.numPasses = std::max(1, std::stoi(argv[++i]));
+        else if (arg == "--verify")                 options.verify = true;
+        else if (arg == "--isa" && hasValue && MyCpuDispatch::fromName(argv[i + 1], instructionSet))
+        {
+            MyCpuDispatch::setOverride(instructionSet);
+            ++i;
+        }
+        else
+        {
+            std::cout << "Usage: CompressorBenchmark [--csv file] [--json file] [--blocks 16,64,...]\n"
+                         "                           [--channels 1,2,...] [--rates 48000,...] [--frames n] [--passes n]\n"
+                         "                           [--isa generic|avx2|avx512] [--verify]\n"
+                         "Without --csv or --json the results are written to stdout as CSV.\n";
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    // The bounds hold with some margin: 16 bit PCM is limited by the rounding
+    // of the output to half an LSB, the wider types by the detector, which
+    // stays within 2^-20 of full scale of the double precision one
+    if (options.verify)
+    {
+        auto passed = verifyFixedPoint<juce::int16>("int16", 78.0, 0.6);
+        passed = verifyFixedPoint<MyInt24>("int24", 125.0, 8.0) && passed;
+        passed = verifyFixedPoint<juce::int32>("int32", 130.0, 2048.0) && passed;
+        passed = verifyAllInstructionSets<float>() && passed;
+        passed = verifyAllInstructionSets<double>() && passed;
+
+        // The bound documented in MyFastMath and MyCompressor::setPrecision()
+        passed = verifyFastGain<float>(0.0005) && passed;
+        passed = verifyFastGain<double>(0.0005) && passed;
+
+        return passed ? 0 : 1;
+    }
+
+    std::vector<BenchmarkResult> results;
+    runBenchmarks<float>(options, results);
+    runBenchmarks<double>(options, results);
+    runFixedPointBenchmarks<juce::int16>(options, "int16", results);
+    runFixedPointBenchmarks<MyInt24>(options, "int24", results);
+    runFixedPointBenchmarks<juce::int32>(options, "int32", results);
+
+    // Every kernel ran with the instruction set picked in its prepare(),
+    // except the fixed point one, which is not dispatched
+    for (auto& r : results)
+        r.instructionSet = MyCpuDispatch::getName(r.kernel == "fixedPoint" ? InstructionSet::generic : MyCpuDispatch::getInstructionSet());
+
+    if (! options.csvFile.empty())
+    {
+        std::ofstream file(options.csvFile);
+        writeCSV(file, results);
+    }
+
+    if (! options.jsonFile.empty())
+    {
+        std::ofstream file(options.jsonFile);
+        writeJSON(file, results);
+    }
+
+    if (options.csvFile.empty() && options.jsonFile.empty())
+        writeCSV(std::cout, results);
+
+    return 0;
+}
@@ -0,0 +1,603 @@
+/*
+  ==============================================================================
+
+    Headless batch renderer: runs MyCompressor over audio files, many files
+    at a time, without a host.
+
+  ==============================================================================
+*/
+
+#include <thread>
+#include <JuceHeader.h>
+#include "../Source/MyCompressor.h"
+#include "../Source/MyBlockTimer.h"
+#include "../Source/MyRealtimeGuard.h"
+#include "../Source/MyParallelRenderer.h"
+
+//==============================================================================
+struct RenderSettings
+{
+    MyCompressorParameters parameters;
+    GainComputerPrecision precision = GainComputerPrecision::exact;
+    ChannelLinkMode linkMode = ChannelLinkMode::none;
+    BallisticsFilterLevelCalculationType levelType = BallisticsFilterLevelCalculationType::peak;
+    bool useDoublePrecision = false;
+    int chunkSize = 65536;
+    int numThreads = 0;
+    int statisticsBlockSize = 0;    // 0 when not measuring
+    bool splitFiles = false;        // --parallel
+    bool verifySplit = false;       // --verify
+    double maximumErrordB = 0.001;
+    juce::File outputDirectory;
+};
+
+struct RenderResult
+{
+    juce::File input, output;
+    juce::String error, statistics;
+    juce::int64 numSamples = 0;
+    double seconds = 0.0;
+};
+
+//==============================================================================
+static int findChoice(const juce::StringArray& choices, const juce::String& value)
+{
+    return juce::jmax(0, choices.indexOf(value, true));
+}
+
+static const juce::StringArray precisionNames{ "exact", "fast" };
+static const juce::StringArray linkNames{ "off", "max", "mean", "weighted" };
+static const juce::StringArray detectorNames{ "peak", "rms", "windowed" };
+static const juce::StringArray keyFilterNames{ "off", "highpass", "bandpass" };
+
+// Options that are followed by a value
+static const juce::StringArray valueOptions{ "--preset", "--threshold", "--ratio", "--attack", "--release", "--lookahead", "--rc-mode",
+                                             "--detector", "--rms-window", "--precision", "--link", "--output-dir", "--chunk", "--threads", "--stats",
+                                             "--key-filter", "--key-frequency", "--key-q", "--max-error", "--isa" };
+
+/** Reads settings from a JSON preset such as
+    { "threshold": -20, "ratio": 4, "attack": 5, "release": 200, "lookahead": 5,
+      "rcMode": 0, "detector": "windowed", "rmsWindow": 300, "precision": "fast", "link": "max",
+      "keyFilter": "highpass", "keyFrequency": 150, "keyQ": 0.7 }
+*/
+static bool loadPreset(const juce::File& file, RenderSettings& settings)
+{
+    auto preset = juce::JSON::parse(file);
+
+    if (! preset.isObject())
+        return false;
+
+    auto& p = settings.parameters;
+    p.thresholddB = preset.getProperty("threshold", p.thresholddB);
+    p.ratio = preset.getProperty("ratio", p.ratio);
+    p.attackTime = preset.getProperty("attack", p.attackTime);
+    p.releaseTime = preset.getProperty("release", p.releaseTime);
+    p.lookaheadTime = preset.getProperty("lookahead", p.lookaheadTime);
+    p.rmsWindowTime = preset.getProperty("rmsWindow", p.rmsWindowTime);
+    p.rcMode = preset.getProperty("rcMode", p.rcMode);
+    p.sidechainFilterFrequency = preset.getProperty("keyFrequency", p.sidechainFilterFrequency);
+    p.sidechainFilterQ = preset.getProperty("keyQ", p.sidechainFilterQ);
+
+    if (preset.hasProperty("keyFilter"))
+        p.sidechainFilterType = static_cast<SidechainFilterType>(findChoice(keyFilterNames, preset["keyFilter"].toString()));
+
+    if (preset.hasProperty("precision"))
+        settings.precision = static_cast<GainComputerPrecision>(findChoice(precisionNames, preset["precision"].toString()));
+
+    if (preset.hasProperty("detector"))
+        settings.levelType = static_cast<BallisticsFilterLevelCalculationType>(findChoice(detectorNames, preset["detector"].toString()));
+
+    if (preset.hasProperty("link"))
+        settings.linkMode = static_cast<ChannelLinkMode>(findChoice(linkNames, preset["link"].toString()));
+
+    return true;
+}
+
+static void applyArguments(const juce::ArgumentList& args, RenderSettings& settings)
+{
+    auto& p = settings.parameters;
+
+    auto readDouble = [&args](const char* option, double& value)
+    {
+        if (args.containsOption(option))
+            value = args.getValueForOption(option).getDoubleValue();
+    };
+
+    readDouble("--threshold", p.thresholddB);
+    readDouble("--ratio", p.ratio);
+    readDouble("--attack", p.attackTime);
+    readDouble("--release", p.releaseTime);
+    readDouble("--lookahead", p.lookaheadTime);
+    readDouble("--rms-window", p.rmsWindowTime);
+    readDouble("--key-frequency", p.sidechainFilterFrequency);
+    readDouble("--key-q", p.sidechainFilterQ);
+
+    if (args.containsOption("--key-filter"))
+        p.sidechainFilterType = static_cast<SidechainFilterType>(findChoice(keyFilterNames, args.getValueForOption("--key-filter")));
+
+    if (args.containsOption("--rc-mode"))
+        p.rcMode = juce::jlimit(0, 2, args.getValueForOption("--rc-mode").getIntValue());
+
+    if (args.containsOption("--precision"))
+        settings.precision = static_cast<GainComputerPrecision>(findChoice(precisionNames, args.getValueForOption("--precision")));
+
+    if (args.containsOption("--detector"))
+        settings.levelType = static_cast<BallisticsFilterLevelCalculationType>(findChoice(detectorNames, args.getValueForOption("--detector")));
+
+    if (args.containsOption("--link"))
+        settings.linkMode = static_cast<ChannelLinkMode>(findChoice(linkNames, args.getValueForOption("--link")));
+
+    if (args.containsOption("--chunk"))
+        settings.chunkSize = juce::jmax(64, args.getValueForOption("--chunk").getIntValue());
+
+    if (args.containsOption("--threads"))
+        settings.numThreads = juce::jmax(1, args.getValueForOption("--threads").getIntValue());
+
+    if (args.containsOption("--stats"))
+        settings.statisticsBlockSize = juce::jlimit(1, settings.chunkSize, args.getValueForOption("--stats").getIntValue());
+
+    if (args.containsOption("--max-error"))
+        settings.maximumErrordB = juce::jmax(1.0e-6, args.getValueForOption("--max-error").getDoubleValue());
+
+    // Takes effect in every compressor prepared from now on
+    InstructionSet instructionSet;
+
+    if (args.containsOption("--isa") && MyCpuDispatch::fromName(args.getValueForOption("--isa"), instructionSet))
+        MyCpuDispatch::setOverride(instructionSet);
+
+    if (args.containsOption("--output-dir"))
+    {
+        settings.outputDirectory = args.getFileForOption("--output-dir");
+        settings.outputDirectory.createDirectory();
+    }
+
+    settings.useDoublePrecision = args.containsOption("--double");
+    settings.splitFiles = args.containsOption("--parallel");
+    settings.verifySplit = settings.splitFiles && args.containsOption("--verify");
+    settings.parameters.ratio = juce::jmax(1.0, settings.parameters.ratio);
+}
+
+//==============================================================================
+/** Creates a writer for result.output in the format of the reader, or sets
+    result.error.
+*/
+static std::unique_ptr<juce::AudioFormatWriter> createWriter(juce::AudioFormatManager& formatManager,
+                                                             const juce::AudioFormatReader& reader, RenderResult& result)
+{
+    auto* format = formatManager.findFormatForFileExtension(result.output.getFileExtension());
+
+    if (format == nullptr)
+    {
+        result.error = "no writer for this file type";
+        return nullptr;
+    }
+
+    const auto bitDepth = format->getPossibleBitDepths().contains((int)reader.bitsPerSample) ? (int)reader.bitsPerSample : 24;
+
+    result.output.deleteFile();
+    auto stream = result.output.createOutputStream();
+
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+
+    if (stream != nullptr)
+        writer.reset(format->createWriterFor(stream.get(), reader.sampleRate, reader.numChannels,
+                                             bitDepth, reader.metadataValues, 0));
+
+    if (writer == nullptr)
+    {
+        result.error = "cannot write " + result.output.getFullPathName();
+        return nullptr;
+    }
+
+    stream.release(); // now owned by the writer
+    return writer;
+}
+
+/** Streams one file through a compressor in fixed size chunks, so memory use
+    does not depend on the file length.
+*/
+template <typename SampleType>
+static void renderFile(const RenderSettings& settings, RenderResult& result)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(result.input));
+
+    if (reader == nullptr)
+    {
+        result.error = "unsupported or unreadable file";
+        return;
+    }
+
+    auto writer = createWriter(formatManager, *reader, result);
+
+    if (writer == nullptr)
+        return;
+
+    const auto numChannels = (int)reader->numChannels;
+
+    MyCompressor<SampleType> compressor;
+    compressor.prepare({ reader->sampleRate, (juce::uint32)settings.chunkSize, (juce::uint32)numChannels });
+    compressor.setCoefficients(MyCompressorCoefficients::calculate(settings.parameters, reader->sampleRate));
+    compressor.setPrecision(settings.precision);
+    compressor.setLinkMode(settings.linkMode);
+    compressor.setLevelCalculationType(settings.levelType);
+
+    // The files are read and written as float, the double engine gets a copy
+    juce::AudioBuffer<float> fileChunk(numChannels, settings.chunkSize);
+    juce::AudioBuffer<SampleType> chunk(std::is_same_v<SampleType, float> ? 0 : numChannels, settings.chunkSize);
+
+    // The lookahead delays the output: run on for that long past the end of the
+    // file (the reader supplies silence there) and drop as much from the start,
+    // so the rendered file lines up with the input
+    const auto latency = (juce::int64)compressor.getLatencySamples();
+    const auto numSamplesToRender = reader->lengthInSamples + latency;
+    auto numSamplesToSkip = latency;
+
+    // With --stats every chunk is processed in host sized blocks, timed and
+    // checked for allocations and locks like processBlock() in the plugin
+    MyBlockTimer blockTimer;
+    blockTimer.prepare(reader->sampleRate);
+
+    const auto process = [&](const juce::dsp::AudioBlock<SampleType>& block)
+    {
+        if (settings.statisticsBlockSize == 0)
+        {
+            compressor.process(juce::dsp::ProcessContextReplacing<SampleType>(block));
+            return;
+        }
+
+        for (size_t start = 0; start < block.getNumSamples(); start += (size_t)settings.statisticsBlockSize)
+        {
+            auto subBlock = block.getSubBlock(start, juce::jmin((size_t)settings.statisticsBlockSize, block.getNumSamples() - start));
+
+            const MyRealtimeGuard::ScopedRealtimeSection realtimeSection;
+            const MyBlockTimer::ScopedMeasurement measurement(blockTimer, (int)subBlock.getNumSamples());
+            compressor.process(juce::dsp::ProcessContextReplacing<SampleType>(subBlock));
+        }
+    };
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    for (juce::int64 position = 0; position < numSamplesToRender; position += settings.chunkSize)
+    {
+        const auto numSamples = (int)juce::jmin((juce::int64)settings.chunkSize, numSamplesToRender - position);
+
+        reader->read(&fileChunk, 0, numSamples, position, true, true);
+
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            process(juce::dsp::AudioBlock<float>(fileChunk).getSubBlock(0, (size_t)numSamples));
+        }
+        else
+        {
+            chunk.makeCopyOf(fileChunk, true);
+            process(juce::dsp::AudioBlock<SampleType>(chunk).getSubBlock(0, (size_t)numSamples));
+            fileChunk.makeCopyOf(chunk, true);
+        }
+
+        const auto skip = (int)juce::jmin(numSamplesToSkip, (juce::int64)numSamples);
+        numSamplesToSkip -= skip;
+
+        if (! writer->writeFromAudioSampleBuffer(fileChunk, skip, numSamples - skip))
+        {
+            result.error = "write failed";
+            return;
+        }
+    }
+
+    result.seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+    result.numSamples = reader->lengthInSamples * numChannels;
+
+    if (settings.statisticsBlockSize > 0)
+        result.statistics = blockTimer.getStatistics().toString();
+}
+
+/** Renders a file with MyParallelRenderer, which splits it into chunks
+    processed on all threads. The file is read and written a window at a time,
+    so its length is not limited by memory. With --verify a serial compressor
+    follows the render, window by window, to report the largest difference
+    and the speedup.
+*/
+template <typename SampleType>
+static void renderFileSplit(const RenderSettings& settings, RenderResult& result)
+{
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(result.input));
+
+    if (reader == nullptr)
+    {
+        result.error = "unsupported or unreadable file";
+        return;
+    }
+
+    // The serial render reads the file on its own, so that both readers move forwards only
+    std::unique_ptr<juce::AudioFormatReader> verifyReader(settings.verifySplit ? formatManager.createReaderFor(result.input) : nullptr);
+
+    if (settings.verifySplit && verifyReader == nullptr)
+    {
+        result.error = "unsupported or unreadable file";
+        return;
+    }
+
+    auto writer = createWriter(formatManager, *reader, result);
+
+    if (writer == nullptr)
+        return;
+
+    typename MyParallelRenderer<SampleType>::Settings split;
+    split.coefficients = MyCompressorCoefficients::calculate(settings.parameters, reader->sampleRate);
+    split.precision = settings.precision;
+    split.linkMode = settings.linkMode;
+    split.levelType = settings.levelType;
+    split.sampleRate = reader->sampleRate;
+    split.maximumErrordB = settings.maximumErrordB;
+    split.blockSize = settings.chunkSize / (int)MyCompressorCoefficients::maximumControlRateFactor
+                    * (int)MyCompressorCoefficients::maximumControlRateFactor;
+    split.numThreads = settings.numThreads;
+
+    // As in renderFile(), the render runs on for the latency past the end
+    const auto numChannels = (int)reader->numChannels;
+    const auto latency = (juce::int64)split.coefficients.lookaheadSamples;
+    const auto numSamples = reader->lengthInSamples + latency;
+
+    // The warm-up depends on the peak, which takes a pass over the file
+    std::vector<juce::Range<float>> levels((size_t)numChannels);
+    reader->readMaxLevels(0, reader->lengthInSamples, levels.data(), numChannels);
+
+    split.inputPeak = 0.0;
+
+    for (auto& range : levels)
+        split.inputPeak = juce::jmax(split.inputPeak, (double)-range.getStart(), (double)range.getEnd());
+
+    // The files are read and written as float, the engine gets a copy
+    juce::AudioBuffer<float> inputWindow, outputWindow;
+
+    const auto read = [&inputWindow, numChannels](juce::AudioFormatReader& source, juce::int64 position,
+                                                  const juce::dsp::AudioBlock<SampleType>& destination)
+    {
+        const auto length = (int)destination.getNumSamples();
+
+        // The reader supplies silence past the end of the file
+        inputWindow.setSize(numChannels, length, false, false, true);
+        source.read(&inputWindow, 0, length, position, true, true);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            std::copy(inputWindow.getReadPointer(channel), inputWindow.getReadPointer(channel) + length,
+                      destination.getChannelPointer((size_t)channel));
+    };
+
+    MyCompressor<SampleType> serialCompressor;
+    juce::AudioBuffer<SampleType> reference;
+    auto serialSeconds = 0.0, maximumDifference = 0.0;
+
+    if (verifyReader != nullptr)
+        MyParallelRenderer<SampleType>::prepareCompressor(serialCompressor, split, (size_t)numChannels);
+
+    juce::int64 outputPosition = 0;
+    auto writeFailed = false;
+
+    const auto write = [&](const juce::dsp::AudioBlock<const SampleType>& output)
+    {
+        const auto length = (int)output.getNumSamples();
+
+        // The windows start on block boundaries, so the serial compressor
+        // processes the same blocks as a serial render of the whole file
+        if (verifyReader != nullptr)
+        {
+            const auto serialStart = juce::Time::getMillisecondCounterHiRes();
+
+            reference.setSize(numChannels, length, false, false, true);
+            const auto referenceBlock = juce::dsp::AudioBlock<SampleType>(reference);
+
+            read(*verifyReader, outputPosition, referenceBlock);
+            MyParallelRenderer<SampleType>::processBlocks(serialCompressor, split, referenceBlock);
+
+            serialSeconds += (juce::Time::getMillisecondCounterHiRes() - serialStart) * 0.001;
+
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                const auto* rendered = output.getChannelPointer((size_t)channel);
+                const auto* expected = reference.getReadPointer(channel);
+
+                for (int i = 0; i < length; ++i)
+                    maximumDifference = juce::jmax(maximumDifference, (double)std::abs(rendered[i] - expected[i]));
+            }
+        }
+
+        outputWindow.setSize(numChannels, length, false, false, true);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+            std::copy(output.getChannelPointer((size_t)channel), output.getChannelPointer((size_t)channel) + length,
+                      outputWindow.getWritePointer(channel));
+
+        // Drop the latency from the start, so the rendered file lines up with the input
+        const auto skip = (int)juce::jlimit((juce::int64)0, (juce::int64)length, latency - outputPosition);
+        outputPosition += length;
+
+        writeFailed = ! writer->writeFromAudioSampleBuffer(outputWindow, skip, length - skip);
+        return ! writeFailed;
+    };
+
+    const auto splitResult = MyParallelRenderer<SampleType>::render(split, numChannels, numSamples,
+                                                                    [&](juce::int64 position, const juce::dsp::AudioBlock<SampleType>& destination)
+                                                                    {
+                                                                        read(*reader, position, destination);
+                                                                    },
+                                                                    write);
+
+    if (writeFailed)
+    {
+        result.error = "write failed";
+        return;
+    }
+
+    result.seconds = splitResult.seconds;
+    result.numSamples = reader->lengthInSamples * numChannels;
+    result.statistics = splitResult.toString();
+
+    if (verifyReader != nullptr)
+        result.statistics << "\n  serial " << juce::String(serialSeconds, 3) << " s, speedup "
+                          << juce::String(serialSeconds / juce::jmax(splitResult.seconds, 1.0e-9), 2)
+                          << ", largest difference " << juce::String(juce::Decibels::gainToDecibels(maximumDifference, -300.0), 1) << " dBFS";
+}
+
+//==============================================================================
+static juce::String formatThroughput(juce::int64 numSamples, double seconds)
+{
+    return juce::String((double)numSamples / juce::jmax(seconds, 1.0e-9) * 1.0e-6, 2) + " Msamples/s";
+}
+
+static void printUsage()
+{
+    std::cout << "Usage: CompressorRender [options] <input files...>\n"
+                 "  --preset <file.json>    settings to start from\n"
+                 "  --threshold=<dB>        --ratio <r>\n"
+                 "  --attack <ms>           --release <ms>\n"
+                 "  --lookahead <ms>        0 to 20, the output stays time aligned\n"
+                 "  --rc-mode <0|1|2>       --precision <exact|fast>\n"
+                 "  --detector <peak|rms|windowed>\n"
+                 "  --rms-window <ms>       window of the windowed RMS detector, up to 500\n"
+                 "  --link <off|max|mean|weighted>\n"
+                 "  --key-filter <off|highpass|bandpass>\n"
+                 "  --key-frequency <Hz>    --key-q <q>\n"
+                 "  --double                use the double precision engine\n"
+                 "  --output-dir <folder>   defaults to <name>_compressed next to the input\n"
+                 "  --chunk <samples>       streaming chunk size (default 65536)\n"
+                 "  --threads <n>           defaults to the number of cores\n"
+                 "  --stats <samples>       process in blocks of this size and print the time\n"
+                 "                          per block against its real-time deadline\n"
+                 "  --parallel              split each file into chunks rendered on all threads,\n"
+                 "                          one file after another\n"
+                 "  --max-error <dB>        largest gain difference from a serial render that\n"
+                 "                          --parallel allows (default 0.001)\n"
+                 "  --verify                with --parallel, also render serially and print the\n"
+                 "                          speedup and the largest difference\n"
+                 "  --isa <generic|avx2|avx512>  kernels to use instead of the detected ones\n"
+                 "Negative values must be attached with '=', e.g. --threshold=-20\n";
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ArgumentList args(argc, argv);
+
+    if (args.size() == 0 || args.containsOption("--help|-h"))
+    {
+        printUsage();
+        return 0;
+    }
+
+    RenderSettings settings;
+
+    if (args.containsOption("--preset") && ! loadPreset(args.getFileForOption("--preset"), settings))
+    {
+        std::cerr << "Cannot read preset\n";
+        return 1;
+    }
+
+    applyArguments(args, settings);
+
+    // Every argument that is not an option or an option's value is an input file
+    std::vector<RenderResult> jobs;
+
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+
+        if (arg.isOption())
+        {
+            if (valueOptions.contains(arg.text))
+                ++i;
+
+            continue;
+        }
+
+        RenderResult job;
+        job.input = arg.resolveAsFile();
+        job.output = settings.outputDirectory.isDirectory()
+                   ? settings.outputDirectory.getChildFile(job.input.getFileName())
+                   : job.input.getSiblingFile(job.input.getFileNameWithoutExtension() + "_compressed" + job.input.getFileExtension());
+        jobs.push_back(job);
+    }
+
+    if (jobs.empty())
+    {
+        printUsage();
+        return 1;
+    }
+
+    // Files are independent and coarse grained, so the workers simply take the
+    // next unclaimed file until none are left: an idle core never waits while
+    // there is still work. With --parallel the threads work inside each file
+    // instead, which also helps with one long recording.
+    const auto numThreads = (size_t)juce::jmin(settings.splitFiles ? std::numeric_limits<int>::max() : (int)jobs.size(),
+                                               settings.numThreads > 0 ? settings.numThreads : juce::SystemStats::getNumCpus());
+    const auto numWorkers = settings.splitFiles ? (size_t)1 : numThreads;
+    std::atomic<size_t> nextJob{ 0 };
+    juce::CriticalSection outputLock;
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+
+    std::vector<std::thread> workers;
+
+    for (size_t t = 0; t < numWorkers; ++t)
+    {
+        workers.emplace_back([&]
+        {
+            for (auto index = nextJob++; index < jobs.size(); index = nextJob++)
+            {
+                auto& job = jobs[index];
+
+                if (! job.input.existsAsFile())
+                    job.error = "file not found";
+                else if (job.output == job.input)
+                    job.error = "output would overwrite the input";
+                else if (settings.splitFiles && settings.useDoublePrecision)
+                    renderFileSplit<double>(settings, job);
+                else if (settings.splitFiles)
+                    renderFileSplit<float>(settings, job);
+                else if (settings.useDoublePrecision)
+                    renderFile<double>(settings, job);
+                else
+                    renderFile<float>(settings, job);
+
+                const juce::ScopedLock lock(outputLock);
+
+                if (job.error.isNotEmpty())
+                    std::cerr << job.input.getFullPathName() << ": " << job.error << "\n";
+                else
+                    std::cout << job.input.getFileName() << ": " << job.numSamples << " samples in "
+                              << juce::String(job.seconds, 3) << " s, " << formatThroughput(job.numSamples, job.seconds) << "\n";
+
+                if (job.statistics.isNotEmpty())
+                    std::cout << "  " << job.statistics << "\n";
+            }
+        });
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    const auto seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001;
+
+    juce::int64 totalSamples = 0;
+    int numFailed = 0;
+
+    for (auto& job : jobs)
+    {
+        totalSamples += job.numSamples;
+        numFailed += job.error.isNotEmpty() ? 1 : 0;
+    }
+
+    std::cout << "Total: " << jobs.size() - (size_t)numFailed << " files, " << totalSamples << " samples in "
+              << juce::String(seconds, 3) << " s on " << numThreads << " threads, "
+              << formatThroughput(totalSamples, seconds) << "\n";
+
+    if (settings.statisticsBlockSize > 0)
+        std::cout << "Real-time violations: " << MyRealtimeGuard::getNumViolations() << "\n";
+
+    return numFailed == 0 ? 0 : 1;
+}
@@ -0,0 +1,142 @@
+#include <JuceHeader.h>
+#include "MyBlockTimer.h"
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+//==============================================================================
+juce::int64 MyBlockTimer::getCycleCount() noexcept
+{
+   #if JUCE_INTEL
+    return (juce::int64)__rdtsc();
+   #else
+    return juce::Time::getHighResolutionTicks();
+   #endif
+}
+
+double MyBlockTimer::getCyclesPerSecond() noexcept
+{
+   #if JUCE_INTEL
+    // The time stamp counter runs at a constant rate on every CPU of the last
+    // fifteen years, which is not reported anywhere: count it over 10 ms once
+    static const double cyclesPerSecond = []
+    {
+        const auto ticksPerSecond = (double)juce::Time::getHighResolutionTicksPerSecond();
+        const auto startTicks = juce::Time::getHighResolutionTicks();
+        const auto startCycles = getCycleCount();
+
+        auto ticks = startTicks;
+
+        while ((double)(ticks - startTicks) < 0.01 * ticksPerSecond)
+            ticks = juce::Time::getHighResolutionTicks();
+
+        return (double)(getCycleCount() - startCycles) * ticksPerSecond / (double)juce::jmax((juce::int64)1, ticks - startTicks);
+    }();
+
+    return cyclesPerSecond;
+   #else
+    return (double)juce::Time::getHighResolutionTicksPerSecond();
+   #endif
+}
+
+//==============================================================================
+void MyBlockTimer::prepare(double sampleRate)
+{
+    jassert(sampleRate > 0);
+
+    cyclesPerSample = getCyclesPerSecond() / sampleRate;
+    clear();
+}
+
+void MyBlockTimer::clear() noexcept
+{
+    for (auto& bin : bins)
+        bin.store(0, std::memory_order_relaxed);
+
+    numBlocks.store(0, std::memory_order_relaxed);
+    numOverruns.store(0, std::memory_order_relaxed);
+    maximumBlockLoad.store(0.0, std::memory_order_relaxed);
+    maximumCycles.store(0, std::memory_order_relaxed);
+    resetRequested = false;
+}
+
+void MyBlockTimer::addBlock(juce::int64 numCycles, int numSamples) noexcept
+{
+    if (numSamples <= 0)
+        return;
+
+    if (resetRequested.load(std::memory_order_relaxed))
+        clear();
+
+    const auto load = (double)numCycles / (cyclesPerSample * numSamples);
+    const auto bin = (size_t)juce::jlimit(0, numBins - 1, (int)(load / loadResolution));
+
+    // Single writer: plain loads and stores are enough, no read-modify-write
+    bins[bin].store(bins[bin].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    numBlocks.store(numBlocks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (load > 1.0)
+        numOverruns.store(numOverruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (load > maximumBlockLoad.load(std::memory_order_relaxed))
+        maximumBlockLoad.store(load, std::memory_order_relaxed);
+
+    if (numCycles > maximumCycles.load(std::memory_order_relaxed))
+        maximumCycles.store(numCycles, std::memory_order_relaxed);
+}
+
+//==============================================================================
+MyBlockTimer::Statistics MyBlockTimer::getStatistics() const
+{
+    std::array<juce::uint32, (size_t)numBins> counts;
+    juce::uint64 total = 0;
+
+    for (size_t bin = 0; bin < counts.size(); ++bin)
+    {
+        counts[bin] = bins[bin].load(std::memory_order_relaxed);
+        total += counts[bin];
+    }
+
+    Statistics statistics;
+    statistics.numBlocks = total;
+    statistics.numOverruns = numOverruns.load(std::memory_order_relaxed);
+    statistics.maximum = maximumBlockLoad.load(std::memory_order_relaxed);
+    statistics.maximumCycles = maximumCycles.load(std::memory_order_relaxed);
+
+    // The percentiles are taken from the bin counts rather than numBlocks, so
+    // they are consistent with each other even if a block is being added
+    const auto findPercentile = [&counts, total](double fraction)
+    {
+        const auto rank = (juce::uint64)std::ceil(fraction * (double)total);
+        juce::uint64 count = 0;
+
+        for (size_t bin = 0; bin < counts.size(); ++bin)
+        {
+            count += counts[bin];
+
+            if (count >= rank && count > 0)
+                return (double)(bin + 1) * loadResolution;
+        }
+
+        return 0.0;
+    };
+
+    statistics.median = juce::jmin(statistics.maximum, findPercentile(0.5));
+    statistics.percentile99 = juce::jmin(statistics.maximum, findPercentile(0.99));
+
+    return statistics;
+}
+
+juce::String MyBlockTimer::Statistics::toString() const
+{
+    const auto percent = [](double load) { return juce::String(load * 100.0, 1) + "%"; };
+
+    return juce::String(numBlocks) + " blocks, load p50 " + percent(median) + " p99 " + percent(percentile99)
+         + " max " + percent(maximum) + " (" + juce::String(maximumCycles) + " cycles), "
+         + juce::String(numOverruns) + " overruns";
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Measures how long every processed block takes, in CPU cycles, and keeps a
+    histogram of that time as a fraction of the block's deadline (the duration
+    of the audio it contains).
+
+    The audio thread is the only writer: addBlock() does a couple of relaxed
+    atomic stores and never locks or allocates. Any other thread may read the
+    statistics at any time; a read that races with a write can be off by one
+    block, which does not matter for percentiles. Resetting is requested by the
+    reader and carried out by the writer at the start of its next block.
+
+    @tags{DSP}
+*/
+class MyBlockTimer
+{
+public:
+    //==============================================================================
+    /** The histogram covers loads up to maximumLoad in steps of loadResolution;
+        anything above lands in the last bin.
+    */
+    static constexpr double maximumLoad = 2.0, loadResolution = 0.01;
+    static constexpr int numBins = (int)(maximumLoad / loadResolution) + 1;
+
+    //==============================================================================
+    /** Sets the sample rate the deadlines are computed from and clears the
+        statistics. The first call calibrates the cycle counter, which takes a
+        few milliseconds.
+    */
+    void prepare(double sampleRate);
+
+    /** Asks the audio thread to clear the statistics before its next block. */
+    void reset() noexcept { resetRequested = true; }
+
+    //==============================================================================
+    /** Returns the current value of the cycle counter: the time stamp counter
+        where there is one, the high resolution tick counter otherwise.
+    */
+    static juce::int64 getCycleCount() noexcept;
+
+    /** Returns the number of getCycleCount() ticks per second. */
+    static double getCyclesPerSecond() noexcept;
+
+    /** Records a block of numSamples samples that took numCycles cycles. */
+    void addBlock(juce::int64 numCycles, int numSamples) noexcept;
+
+    /** Times the lifetime of the object and records it as one block. */
+    class ScopedMeasurement
+    {
+    public:
+        ScopedMeasurement(MyBlockTimer& timerToUse, int numSamplesInBlock) noexcept
+            : timer(timerToUse), numSamples(numSamplesInBlock), start(getCycleCount()) {}
+
+        ~ScopedMeasurement() noexcept { timer.addBlock(getCycleCount() - start, numSamples); }
+
+    private:
+        MyBlockTimer& timer;
+        const int numSamples;
+        const juce::int64 start;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedMeasurement)
+    };
+
+    //==============================================================================
+    struct Statistics
+    {
+        juce::uint64 numBlocks = 0, numOverruns = 0;
+
+        /** Loads as a fraction of the deadline, so 1.0 means the block took as
+            long as the audio it contains. The percentiles are upper bin edges,
+            limited to the maximum.
+        */
+        double median = 0.0, percentile99 = 0.0, maximum = 0.0;
+
+        juce::int64 maximumCycles = 0;
+
+        /** A one line summary, for the editor or a log. */
+        juce::String toString() const;
+    };
+
+    /** Computes the statistics from the histogram. Not for the audio thread. */
+    Statistics getStatistics() const;
+
+private:
+    //==============================================================================
+    void clear() noexcept;
+
+    std::array<std::atomic<juce::uint32>, (size_t)numBins> bins{};
+    std::atomic<juce::uint64> numBlocks{ 0 }, numOverruns{ 0 };
+    std::atomic<double> maximumBlockLoad{ 0.0 };
+    std::atomic<juce::int64> maximumCycles{ 0 };
+    std::atomic<bool> resetRequested{ false };
+
+    double cyclesPerSample = 1.0;
+};
@@ -35,6 +35,15 @@
 */
 #include <JuceHeader.h>
 
+// The block kernels are compiled for several instruction sets, only some of
+// which have fused multiply-adds. Without contraction all of them round the
+// same way, see MyCpuDispatch.
+#if JUCE_GCC
+ #pragma GCC optimize ("fp-contract=off")
+#elif JUCE_CLANG
+ #pragma STDC FP_CONTRACT OFF
+#endif
+
 //==============================================================================
 template <typename SampleType>
 MyCompressor<SampleType>::MyCompressor()
@@ -73,6 +82,170 @@ void MyCompressor<SampleType>::setRelease(SampleType newRelease)
     update();
 }
 
+template <typename SampleType>
+void MyCompressor<SampleType>::setLookahead(SampleType newLookahead)
+{
+    jassert(newLookahead >= static_cast<SampleType> (0.0));
+
+    lookaheadTime = newLookahead;
+    update();
+}
+
+template <typename SampleType>
+int MyCompressor<SampleType>::getLatencySamples() const noexcept
+{
+    return lookahead.getDelay();
+}
+
+template <typename SampleType>
+double MyCompressor<SampleType>::getTailLengthSeconds() const noexcept
+{
+    return (double)lookahead.getDelay() / sampleRate
+         + MyEnvelopeDetector<SampleType>::getDecayTime(releaseTime, rcMode, envelopeFilter.getLevelCalculationType(), rmsWindow);
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::setLevelCalculationType(BallisticsFilterLevelCalculationType newType)
+{
+    envelopeFilter.setLevelCalculationType(newType);
+    controlFilter.setLevelCalculationType(newType);
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::setRMSWindow(SampleType newRMSWindow)
+{
+    jassert(newRMSWindow > static_cast<SampleType> (0.0));
+
+    rmsWindow = newRMSWindow;
+    update();
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::setSidechainFilter(SidechainFilterType newType, SampleType newFrequency, SampleType newQ)
+{
+    jassert(newFrequency > static_cast<SampleType> (0.0) && newQ > static_cast<SampleType> (0.0));
+
+    sidechainFilterType = newType;
+    sidechainFilterFrequency = newFrequency;
+    sidechainFilterQ = newQ;
+    update();
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::setPrecision(GainComputerPrecision newPrecision)
+{
+    precision = newPrecision;
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::setControlRate(bool shouldUseControlRate)
+{
+    controlRate = shouldUseControlRate;
+    update();
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::setLinkMode(ChannelLinkMode newLinkMode)
+{
+    linkMode = newLinkMode;
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::setLinkWeight(int channel, SampleType newWeight)
+{
+    jassert(juce::isPositiveAndBelow(channel, linkWeights.size()));
+    linkWeights[(size_t)channel] = newWeight;
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::setCoefficients(const MyCompressorCoefficients& newCoefficients) noexcept
+{
+    const auto& p = newCoefficients.parameters;
+
+    thresholddB = static_cast<SampleType> (p.thresholddB);
+    ratio = static_cast<SampleType> (p.ratio);
+    attackTime = static_cast<SampleType> (p.attackTime);
+    releaseTime = static_cast<SampleType> (p.releaseTime);
+    lookaheadTime = static_cast<SampleType> (p.lookaheadTime);
+    rmsWindow = static_cast<SampleType> (p.rmsWindowTime);
+    rcMode = p.rcMode;
+    sidechainFilterType = p.sidechainFilterType;
+    sidechainFilterFrequency = static_cast<SampleType> (p.sidechainFilterFrequency);
+    sidechainFilterQ = static_cast<SampleType> (p.sidechainFilterQ);
+    controlRate = p.controlRate;
+
+    threshold = static_cast<SampleType> (newCoefficients.threshold);
+    thresholdInverse = static_cast<SampleType> (newCoefficients.thresholdInverse);
+    ratioInverse = static_cast<SampleType> (newCoefficients.ratioInverse);
+    log2Threshold = static_cast<SampleType> (newCoefficients.log2Threshold);
+    slope = static_cast<SampleType> (newCoefficients.slope);
+
+    envelopeFilter.setCoefficients(attackTime, releaseTime, rcMode,
+                                   static_cast<SampleType> (newCoefficients.cteAT),
+                                   static_cast<SampleType> (newCoefficients.cteRL));
+    envelopeFilter.setRMSWindowLength(newCoefficients.rmsWindowSamples);
+    controlFilter.setCoefficients(attackTime, releaseTime, rcMode,
+                                  static_cast<SampleType> (newCoefficients.controlCteAT),
+                                  static_cast<SampleType> (newCoefficients.controlCteRL));
+    controlFilter.setRMSWindowLength(newCoefficients.controlRMSWindowSamples);
+    lookahead.setDelay(newCoefficients.lookaheadSamples);
+    sidechainFilter.setCoefficients(newCoefficients);
+
+    // A new decimation starts a new control period, the partial level of the
+    // running one was measured over the wrong number of samples
+    const auto newControlRateFactor = (size_t)newCoefficients.controlRateFactor;
+
+    if (newControlRateFactor != controlRateFactor)
+    {
+        controlRateFactor = newControlRateFactor;
+        controlPhase = 0;
+        std::fill(controlLevels.begin(), controlLevels.end(), static_cast<SampleType> (0.0));
+    }
+
+    gainRamp = GainRamp();
+    gainRamp.thresholddB = thresholddB;
+    gainRamp.ratioInverse = ratioInverse;
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::setCoefficients(const MyCompressorCoefficients& newCoefficients, int numRampSamples) noexcept
+{
+    // Start from wherever a previous ramp got to
+    const auto startThresholddB = gainRamp.thresholddB;
+    const auto startRatioInverse = gainRamp.ratioInverse;
+
+    setCoefficients(newCoefficients);
+
+    if (numRampSamples <= 0 || (startThresholddB == thresholddB && startRatioInverse == ratioInverse))
+        return;
+
+    const auto rampLength = static_cast<SampleType> (numRampSamples);
+
+    gainRamp.thresholddB = startThresholddB;
+    gainRamp.ratioInverse = startRatioInverse;
+    gainRamp.thresholddBStep = (thresholddB - startThresholddB) / rampLength;
+    gainRamp.ratioInverseStep = (ratioInverse - startRatioInverse) / rampLength;
+    gainRamp.numSamplesRemaining = (size_t)numRampSamples;
+}
+
+template <typename SampleType>
+MyCompressorParameters MyCompressor<SampleType>::getParameters() const noexcept
+{
+    MyCompressorParameters p;
+    p.thresholddB = thresholddB;
+    p.ratio = ratio;
+    p.attackTime = attackTime;
+    p.releaseTime = releaseTime;
+    p.lookaheadTime = lookaheadTime;
+    p.rmsWindowTime = rmsWindow;
+    p.rcMode = rcMode;
+    p.sidechainFilterType = sidechainFilterType;
+    p.sidechainFilterFrequency = sidechainFilterFrequency;
+    p.sidechainFilterQ = sidechainFilterQ;
+    p.controlRate = controlRate;
+    return p;
+}
+
 //==============================================================================
 template <typename SampleType>
 void MyCompressor<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
@@ -81,8 +254,24 @@ void MyCompressor<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
     jassert(spec.numChannels > 0);
 
     sampleRate = spec.sampleRate;
+    instructionSet = MyCpuDispatch::getInstructionSet();
 
     envelopeFilter.prepare(spec);
+    controlFilter.prepare(spec);
+    sidechainFilter.prepare(spec);
+    lookahead.prepare({ spec.sampleRate, (juce::uint32)kernelBlockSize, spec.numChannels },
+                      juce::roundToInt(MyCompressorParameters::maximumLookaheadTime * 0.001 * sampleRate));
+    linkWeights.assign(spec.numChannels, static_cast<SampleType> (1.0));
+
+    // Padded like the detector state, so the kernels can address whole lane groups
+    const auto lanes = SIMDType::size();
+    const auto numPaddedChannels = ((spec.numChannels + lanes - 1) / lanes) * lanes;
+
+    controlLevels.resize(numPaddedChannels);
+    controlStartGains.resize(numPaddedChannels);
+    controlTargetGains.resize(numPaddedChannels);
+
+    bypassFadeSamples = (size_t)juce::jmax(1, juce::roundToInt(bypassFadeTime * 0.001 * sampleRate));
 
     update();
     reset();
@@ -92,44 +281,922 @@ template <typename SampleType>
 void MyCompressor<SampleType>::reset()
 {
     envelopeFilter.reset();
+    controlFilter.reset();
+    sidechainFilter.reset();
+    lookahead.reset();
+    numSilentKeySamples = 0;
+
+    controlPhase = 0;
+    std::fill(controlLevels.begin(), controlLevels.end(), static_cast<SampleType> (0.0));
+    std::fill(controlStartGains.begin(), controlStartGains.end(), static_cast<SampleType> (1.0));
+    std::fill(controlTargetGains.begin(), controlTargetGains.end(), static_cast<SampleType> (1.0));
+
+    // A fade in progress jumps to its end
+    bypassFade.wet = static_cast<SampleType> (bypassFade.isBypassed ? 0.0 : 1.0);
+    bypassFade.numSamplesRemaining = 0;
 }
 
 //==============================================================================
 template <typename SampleType>
 SampleType MyCompressor<SampleType>::processSample(int channel, SampleType inputValue)
 {
+    auto key = inputValue;
+
+    if (sidechainFilter.isEnabled())
+        key = sidechainFilter.processSample((size_t)channel, key);
+
     //Ballistics filter with peak rectifier
-    auto env = envelopeFilter.processSample(channel, inputValue);
-    env = juce::Decibels::gainToDecibels(env, minus_inf);
+    auto env = envelopeFilter.processSample(channel, key);
+
+    if (isBelowThreshold<false>(env))
+        return inputValue;
+
+    auto gain = precision == GainComputerPrecision::fast ? computeGainFast(env, log2Threshold, slope)
+                                                         : computeGainExact(env, thresholddB, ratioInverse);
+    return inputValue * gain;
+}
+
+template <typename SampleType>
+SampleType MyCompressor<SampleType>::computeStaticGain(SampleType level, bool isMeanSquare) const noexcept
+{
+    auto value = level;
+
+    if (precision == GainComputerPrecision::exact)
+    {
+        computeGain<GainComputerPrecision::exact, false>(&value, 1);
+    }
+    else if (isMeanSquare)
+    {
+        value = level * level;
+        computeGain<GainComputerPrecision::fast, true>(&value, 1);
+    }
+    else
+    {
+        computeGain<GainComputerPrecision::fast, false>(&value, 1);
+    }
+
+    return value;
+}
+
+template <typename SampleType>
+SampleType MyCompressor<SampleType>::computeGainExact(SampleType envelope, SampleType thrdB, SampleType ratioInv) const noexcept
+{
+    auto env = juce::Decibels::gainToDecibels(envelope, minus_inf);
 
     // VCA
     /* auto gain = (env < threshold) ? static_cast<SampleType> (1.0)
                                     : std::pow (env * thresholdInverse, ratioInverse - static_cast<SampleType> (1.0));*/
-    auto y = (env < thresholddB) ? env : thresholddB + ((env - thresholddB) / ratio);
-    auto gain = juce::Decibels::decibelsToGain(y - env, minus_inf);
-    
-    /*auto input = juce::Decibels::gainToDecibels(abs(inputValue));
-    DBG("input: " << input << " threshold: " << thresholddB);
-    auto y = (input <= thresholddB) ? input : thresholddB + (input - thresholddB) / ratio;
-    auto gain = juce::Decibels::decibelsToGain(y - input);*/
-    return inputValue * gain;
+    auto y = (env < thrdB) ? env : thrdB + ((env - thrdB) * ratioInv);
+    return juce::Decibels::decibelsToGain(y - env, minus_inf);
+}
+
+template <typename SampleType>
+forcedinline SampleType MyCompressor<SampleType>::computeGainFast(SampleType envelope, SampleType log2Thr, SampleType slopeValue) noexcept
+{
+    // Same static curve as computeGainExact(), written in the log2 domain:
+    // gain = 2 ^ ((1 / ratio - 1) * max (log2 (env) - log2 (threshold), 0))
+    auto overshoot = MyFastMath<SampleType>::positivePart(MyFastMath<SampleType>::log2(envelope) - log2Thr);
+    return MyFastMath<SampleType>::exp2(overshoot * slopeValue);
+}
+
+template <typename SampleType>
+template <BallisticsFilterLevelCalculationType levelType, GainComputerPrecision gainPrecision, bool isDecimated>
+void MyCompressor<SampleType>::processChannelGroup(size_t firstChannel, size_t numLanes,
+                                                   const SampleType* const* inputs, const SampleType* const* keys,
+                                                   SampleType* const* outputs, size_t numSamples) noexcept
+{
+    constexpr auto lanes = SIMDType::size();
+
+    // Interleaved scratch: sample i of lane l lives at [i * lanes + l]. Unused
+    // lanes stay silent so they never disturb the envelope state.
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, kernelBlockSize * lanes> frames{};
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, kernelBlockSize * lanes> envelope;
+
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, kernelBlockSize> peak;
+
+    // Both RMS detectors produce a mean square. The fast gain computer takes it
+    // as it is, folding the square root into its log2, so only the exact one
+    // needs std::sqrt.
+    constexpr auto isMeanSquare = levelType != LevelCalculationType::peak;
+    constexpr auto needsSquareRoot = isMeanSquare && gainPrecision == GainComputerPrecision::exact;
+    const auto hasLookahead = lookahead.getDelay() > 0;
+    const auto hasSidechainFilter = sidechainFilter.isEnabled();
+
+    // Metering, reduced across lanes at the end. Unused lanes are silent and
+    // have a unity gain, so they do not disturb the results.
+    auto inputPeak = SIMDType::expand(static_cast<SampleType> (0.0));
+    auto envelopePeak = inputPeak;
+    auto minimumGain = SIMDType::expand(static_cast<SampleType> (1.0));
+
+    // Every channel group runs the same ramp from the start of the block
+    auto ramp = gainRamp;
+
+    const auto isDetectorOnly = bypassFade.isDetectorOnly();
+    const auto isFading = bypassFade.numSamplesRemaining > 0;
+
+    for (size_t start = 0; start < numSamples; start += kernelBlockSize)
+    {
+        const auto numFrames = juce::jmin(kernelBlockSize, numSamples - start);
+        const auto numValues = numFrames * lanes;
+
+        // The key is read before anything is written, so the input, key and
+        // output may all be the same buffer
+        for (size_t lane = 0; lane < numLanes; ++lane)
+            for (size_t i = 0; i < numFrames; ++i)
+                frames[i * lanes + lane] = keys[lane][start + i];
+
+        if (hasSidechainFilter)
+            sidechainFilter.processLanes(firstChannel, frames.data(), numFrames);
+
+        if (hasLookahead)
+        {
+            // The detector gets the peak over the lookahead window and the
+            // delayed audio goes straight to the output, to be scaled in place
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                for (size_t i = 0; i < numFrames; ++i)
+                    peak[i] = frames[i * lanes + lane];
+
+                lookahead.processPeak(firstChannel + lane, peak.data(), peak.data(), numFrames);
+                lookahead.processDelay(firstChannel + lane, inputs[lane] + start, outputs[lane] + start, numFrames);
+
+                for (size_t i = 0; i < numFrames; ++i)
+                    frames[i * lanes + lane] = peak[i];
+            }
+        }
+
+        for (size_t i = 0; i < numValues; i += lanes)
+            inputPeak = SIMDType::max(inputPeak, SIMDType::abs(SIMDType::fromRawArray(frames.data() + i)));
+
+        std::array<bool, kernelBlockSize / gainSegmentSize> isUnity{};
+
+        if constexpr (isDecimated)
+        {
+            // Control rate: the envelope buffer receives the interpolated gain.
+            // Segments where it is exactly 1 in every lane skip the VCA.
+            const auto phase = (controlPhase + start) % controlRateFactor;
+            auto controlPeak = static_cast<SampleType> (0.0);
+            const auto isChunkUnity = computeControlRateGains<levelType, gainPrecision, lanes>(firstChannel, frames.data(), envelope.data(),
+                                                                                                numFrames, phase, ramp, controlPeak);
+            envelopePeak = SIMDType::max(envelopePeak, SIMDType::expand(controlPeak));
+            advanceRamp(ramp, numFrames);
+
+            for (size_t segment = 0; segment < numFrames; segment += gainSegmentSize)
+            {
+                const auto segmentEnd = juce::jmin(numFrames, segment + gainSegmentSize);
+
+                isUnity[segment / gainSegmentSize] = isChunkUnity
+                    || std::all_of(envelope.begin() + (std::ptrdiff_t)(segment * lanes),
+                                   envelope.begin() + (std::ptrdiff_t)(segmentEnd * lanes),
+                                   [](SampleType gain) { return gain == static_cast<SampleType> (1.0); });
+            }
+        }
+        else
+        {
+            // Detector pass: the only loop-carried part of the kernel, writing the
+            // envelope of the whole chunk
+            envelopeFilter.processEnvelopeLanes(firstChannel, frames.data(), envelope.data(), numFrames);
+
+            // Gain pass, overwriting the envelope with the gain to apply. Segments
+            // whose envelope stays below the threshold in every lane have a gain
+            // of exactly 1 and skip it, as well as the VCA. While the threshold is
+            // ramping the whole chunk goes through the gain computer. Once
+            // bypassed every segment skips it.
+            const auto isRamping = ramp.numSamplesRemaining > 0 && ! isDetectorOnly;
+
+            for (size_t segment = 0; segment < numFrames; segment += gainSegmentSize)
+            {
+                auto* segmentEnvelope = envelope.data() + segment * lanes;
+                const auto numSegmentValues = juce::jmin(gainSegmentSize, numFrames - segment) * lanes;
+
+                auto segmentPeak = SIMDType::expand(static_cast<SampleType> (0.0));
+
+                for (size_t i = 0; i < numSegmentValues; i += lanes)
+                    segmentPeak = SIMDType::max(segmentPeak, SIMDType::fromRawArray(segmentEnvelope + i));
+
+                envelopePeak = SIMDType::max(envelopePeak, segmentPeak);
+
+                auto segmentMaximum = segmentPeak.get(0);
+
+                for (size_t lane = 1; lane < lanes; ++lane)
+                    segmentMaximum = juce::jmax(segmentMaximum, segmentPeak.get(lane));
+
+                if (isDetectorOnly || (! isRamping && isBelowThreshold<isMeanSquare>(segmentMaximum)))
+                {
+                    isUnity[segment / gainSegmentSize] = true;
+                    continue;
+                }
+
+                if constexpr (needsSquareRoot)
+                    for (size_t i = 0; i < numSegmentValues; ++i)
+                        segmentEnvelope[i] = std::sqrt(segmentEnvelope[i]);
+
+                if (! isRamping)
+                    computeGain<gainPrecision, isMeanSquare && ! needsSquareRoot>(segmentEnvelope, numSegmentValues);
+            }
+
+            if (isRamping)
+                computeGainRamped<gainPrecision, isMeanSquare && ! needsSquareRoot>(envelope.data(), numFrames, lanes, ramp);
+        }
+
+        // VCA. With lookahead the output already holds the delayed input.
+        for (size_t segment = 0; segment < numFrames; segment += gainSegmentSize)
+        {
+            const auto segmentEnd = juce::jmin(numFrames, segment + gainSegmentSize);
+
+            if (isUnity[segment / gainSegmentSize])
+            {
+                if (! hasLookahead)
+                    for (size_t lane = 0; lane < numLanes; ++lane)
+                        if (inputs[lane] != outputs[lane])
+                            std::copy(inputs[lane] + start + segment, inputs[lane] + start + segmentEnd, outputs[lane] + start + segment);
+
+                continue;
+            }
+
+            if (isFading)
+                applyBypassFade(envelope.data(), lanes, start, segment, segmentEnd);
+
+            for (size_t i = segment * lanes; i < segmentEnd * lanes; i += lanes)
+                minimumGain = SIMDType::min(minimumGain, SIMDType::fromRawArray(envelope.data() + i));
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                const auto* input = hasLookahead ? outputs[lane] + start : inputs[lane] + start;
+                auto* output = outputs[lane] + start;
+
+                for (size_t i = segment; i < segmentEnd; ++i)
+                    output[i] = input[i] * envelope[i * lanes + lane];
+            }
+        }
+    }
+
+    for (size_t lane = 0; lane < lanes; ++lane)
+    {
+        // The envelope peak was taken before any square root
+        const auto env = isMeanSquare ? std::sqrt(envelopePeak.get(lane)) : envelopePeak.get(lane);
+
+        meterInputPeak = juce::jmax(meterInputPeak, inputPeak.get(lane));
+        meterEnvelopePeak = juce::jmax(meterEnvelopePeak, env);
+        meterMinimumGain = juce::jmin(meterMinimumGain, minimumGain.get(lane));
+    }
+}
+
+template <typename SampleType>
+template <BallisticsFilterLevelCalculationType levelType, GainComputerPrecision gainPrecision, bool isDecimated>
+void MyCompressor<SampleType>::processLinked(const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                                             const juce::dsp::AudioBlock<const SampleType>& keyBlock,
+                                             const juce::dsp::AudioBlock<SampleType>& outputBlock) noexcept
+{
+    constexpr auto lanes = SIMDType::size();
+    const auto numChannels = outputBlock.getNumChannels();
+    const auto numKeyChannels = keyBlock.getNumChannels();
+    const auto numSamples = outputBlock.getNumSamples();
+
+    jassert(numChannels <= linkWeights.size());
+    jassert(numKeyChannels <= linkWeights.size());
+
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, kernelBlockSize> key;
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, kernelBlockSize> envelope;
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, kernelBlockSize * lanes> frames{};
+
+    // The channel weights describe the layout of the input, so a sidechain
+    // with another number of channels is averaged instead
+    const auto meanWeight = static_cast<SampleType> (1.0) / static_cast<SampleType> (numKeyChannels);
+    const auto useLinkWeights = linkMode == ChannelLinkMode::weighted && numKeyChannels == numChannels;
+    const auto hasLookahead = lookahead.getDelay() > 0;
+    auto envelopePeak = static_cast<SampleType> (0.0);
+
+    // See processChannelGroup()
+    constexpr auto isMeanSquare = levelType != LevelCalculationType::peak;
+    constexpr auto needsSquareRoot = isMeanSquare && gainPrecision == GainComputerPrecision::exact;
+    const auto isDetectorOnly = bypassFade.isDetectorOnly();
+    const auto isFading = bypassFade.numSamplesRemaining > 0;
+
+    // Combines one key channel, stride samples apart, into the detector signal
+    const auto addToKey = [&](size_t keyChannel, const SampleType* samples, size_t stride, size_t numFrames)
+    {
+        if (linkMode == ChannelLinkMode::max)
+        {
+            for (size_t i = 0; i < numFrames; ++i)
+                key[i] = juce::jmax(key[i], std::abs(samples[i * stride]));
+        }
+        else
+        {
+            const auto weight = useLinkWeights ? linkWeights[keyChannel] : meanWeight;
+
+            for (size_t i = 0; i < numFrames; ++i)
+                key[i] += weight * std::abs(samples[i * stride]);
+        }
+    };
+
+    for (size_t start = 0; start < numSamples; start += kernelBlockSize)
+    {
+        const auto numFrames = juce::jmin(kernelBlockSize, numSamples - start);
+
+        // Combine the rectified channels into one detector signal. The key
+        // filter runs before the rectifier, on the channels side by side.
+        std::fill(key.begin(), key.begin() + (std::ptrdiff_t)numFrames, static_cast<SampleType> (0.0));
+
+        if (sidechainFilter.isEnabled())
+        {
+            for (size_t firstChannel = 0; firstChannel < numKeyChannels; firstChannel += lanes)
+            {
+                const auto numLanes = juce::jmin(lanes, numKeyChannels - firstChannel);
+
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                {
+                    const auto* samples = keyBlock.getChannelPointer(firstChannel + lane) + start;
+
+                    for (size_t i = 0; i < numFrames; ++i)
+                        frames[i * lanes + lane] = samples[i];
+                }
+
+                sidechainFilter.processLanes(firstChannel, frames.data(), numFrames);
+
+                for (size_t lane = 0; lane < numLanes; ++lane)
+                    addToKey(firstChannel + lane, frames.data() + lane, lanes, numFrames);
+            }
+        }
+        else
+        {
+            for (size_t channel = 0; channel < numKeyChannels; ++channel)
+                addToKey(channel, keyBlock.getChannelPointer(channel) + start, 1, numFrames);
+        }
+
+        // The shared key gets one peak window, kept in the slot of the first channel
+        if (hasLookahead)
+            lookahead.processPeak(0, key.data(), key.data(), numFrames);
+
+        for (size_t i = 0; i < numFrames; ++i)
+            meterInputPeak = juce::jmax(meterInputPeak, key[i]);
+
+        std::array<bool, kernelBlockSize / gainSegmentSize> isUnity{};
+
+        if constexpr (isDecimated)
+        {
+            // The shared key gets one control rate state, in the slot of the first channel
+            auto ramp = gainRamp;
+            advanceRamp(ramp, start);
+
+            const auto phase = (controlPhase + start) % controlRateFactor;
+            const auto isChunkUnity = computeControlRateGains<levelType, gainPrecision, 1>(0, key.data(), envelope.data(),
+                                                                                            numFrames, phase, ramp, envelopePeak);
+
+            for (size_t segment = 0; segment < numFrames; segment += gainSegmentSize)
+                isUnity[segment / gainSegmentSize] = isChunkUnity
+                    || std::all_of(envelope.begin() + (std::ptrdiff_t)segment,
+                                   envelope.begin() + (std::ptrdiff_t)juce::jmin(numFrames, segment + gainSegmentSize),
+                                   [](SampleType gain) { return gain == static_cast<SampleType> (1.0); });
+        }
+        else
+        {
+            // Detector pass: one envelope, kept in the state of the first channel
+            envelopeFilter.processEnvelope(0, key.data(), envelope.data(), numFrames);
+
+            // Gain pass, skipping the segments below the threshold like
+            // processChannelGroup() does
+            const auto isRamping = gainRamp.numSamplesRemaining > 0 && ! isDetectorOnly;
+
+            for (size_t segment = 0; segment < numFrames; segment += gainSegmentSize)
+            {
+                auto* segmentEnvelope = envelope.data() + segment;
+                const auto numSegmentFrames = juce::jmin(gainSegmentSize, numFrames - segment);
+
+                auto segmentPeak = static_cast<SampleType> (0.0);
+
+                for (size_t i = 0; i < numSegmentFrames; ++i)
+                    segmentPeak = juce::jmax(segmentPeak, segmentEnvelope[i]);
+
+                envelopePeak = juce::jmax(envelopePeak, segmentPeak);
+
+                if (isDetectorOnly || (! isRamping && isBelowThreshold<isMeanSquare>(segmentPeak)))
+                {
+                    isUnity[segment / gainSegmentSize] = true;
+                    continue;
+                }
+
+                if constexpr (needsSquareRoot)
+                    for (size_t i = 0; i < numSegmentFrames; ++i)
+                        segmentEnvelope[i] = std::sqrt(segmentEnvelope[i]);
+
+                if (! isRamping)
+                    computeGain<gainPrecision, isMeanSquare && ! needsSquareRoot>(segmentEnvelope, numSegmentFrames);
+            }
+
+            if (isRamping)
+            {
+                auto ramp = gainRamp;
+                advanceRamp(ramp, start);
+                computeGainRamped<gainPrecision, isMeanSquare && ! needsSquareRoot>(envelope.data(), numFrames, 1, ramp);
+            }
+        }
+
+        for (size_t segment = 0; segment < numFrames; segment += gainSegmentSize)
+        {
+            if (isUnity[segment / gainSegmentSize])
+                continue;
+
+            const auto segmentEnd = juce::jmin(numFrames, segment + gainSegmentSize);
+
+            if (isFading)
+                applyBypassFade(envelope.data(), 1, start, segment, segmentEnd);
+
+            for (size_t i = segment; i < segmentEnd; ++i)
+                meterMinimumGain = juce::jmin(meterMinimumGain, envelope[i]);
+        }
+
+        // VCA, the same gain for every channel
+        for (size_t channel = 0; channel < numChannels; ++channel)
+        {
+            const auto* input = inputBlock.getChannelPointer(channel) + start;
+            auto* output = outputBlock.getChannelPointer(channel) + start;
+
+            if (hasLookahead)
+            {
+                lookahead.processDelay(channel, input, output, numFrames);
+                input = output;
+            }
+
+            for (size_t segment = 0; segment < numFrames; segment += gainSegmentSize)
+            {
+                const auto segmentEnd = juce::jmin(numFrames, segment + gainSegmentSize);
+
+                if (! isUnity[segment / gainSegmentSize])
+                {
+                    for (size_t i = segment; i < segmentEnd; ++i)
+                        output[i] = input[i] * envelope[i];
+                }
+                else if (input != output)
+                {
+                    std::copy(input + segment, input + segmentEnd, output + segment);
+                }
+            }
+        }
+    }
+
+    // The envelope peak was taken before any square root
+    meterEnvelopePeak = juce::jmax(meterEnvelopePeak, isMeanSquare ? std::sqrt(envelopePeak) : envelopePeak);
+}
+
+template <typename SampleType>
+template <InstructionSet isa, BallisticsFilterLevelCalculationType levelType, GainComputerPrecision gainPrecision, bool isDecimated>
+void MyCompressor<SampleType>::processChannelGroupFor(size_t firstChannel, size_t numLanes,
+                                                      const SampleType* const* inputs, const SampleType* const* keys,
+                                                      SampleType* const* outputs, size_t numSamples) noexcept
+{
+    MyCpuDispatch::Target<isa>::call([&]
+    {
+        processChannelGroup<levelType, gainPrecision, isDecimated>(firstChannel, numLanes, inputs, keys, outputs, numSamples);
+    });
+}
+
+template <typename SampleType>
+template <InstructionSet isa, BallisticsFilterLevelCalculationType levelType, GainComputerPrecision gainPrecision, bool isDecimated>
+void MyCompressor<SampleType>::processLinkedFor(const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                                                const juce::dsp::AudioBlock<const SampleType>& keyBlock,
+                                                const juce::dsp::AudioBlock<SampleType>& outputBlock) noexcept
+{
+    MyCpuDispatch::Target<isa>::call([&]
+    {
+        processLinked<levelType, gainPrecision, isDecimated>(inputBlock, keyBlock, outputBlock);
+    });
+}
+
+template <typename SampleType>
+typename MyCompressor<SampleType>::Kernels MyCompressor<SampleType>::getKernels() const noexcept
+{
+#if MY_CPU_DISPATCH
+    switch (instructionSet)
+    {
+        case InstructionSet::avx2:      return getKernelsFor<InstructionSet::avx2>();
+        case InstructionSet::avx512:    return getKernelsFor<InstructionSet::avx512>();
+        case InstructionSet::generic:
+        default:                        break;
+    }
+#endif
+
+    return getKernelsFor<InstructionSet::generic>();
+}
+
+template <typename SampleType>
+template <InstructionSet isa>
+typename MyCompressor<SampleType>::Kernels MyCompressor<SampleType>::getKernelsFor() const noexcept
+{
+    using Type = LevelCalculationType;
+    using Precision = GainComputerPrecision;
+
+    // Indexed by level calculation type, then by precision, then by control rate
+    static constexpr Kernels kernels[3][2][2] = {
+        { { makeKernels<isa, Type::peak, Precision::exact, false>(), makeKernels<isa, Type::peak, Precision::exact, true>() },
+          { makeKernels<isa, Type::peak, Precision::fast, false>(), makeKernels<isa, Type::peak, Precision::fast, true>() } },
+        { { makeKernels<isa, Type::RMS, Precision::exact, false>(), makeKernels<isa, Type::RMS, Precision::exact, true>() },
+          { makeKernels<isa, Type::RMS, Precision::fast, false>(), makeKernels<isa, Type::RMS, Precision::fast, true>() } },
+        { { makeKernels<isa, Type::windowedRMS, Precision::exact, false>(), makeKernels<isa, Type::windowedRMS, Precision::exact, true>() },
+          { makeKernels<isa, Type::windowedRMS, Precision::fast, false>(), makeKernels<isa, Type::windowedRMS, Precision::fast, true>() } }
+    };
+
+    return kernels[(size_t)envelopeFilter.getLevelCalculationType()][(size_t)precision][controlRateFactor > 1 ? 1 : 0];
+}
+
+template <typename SampleType>
+template <BallisticsFilterLevelCalculationType levelType, GainComputerPrecision gainPrecision, size_t numLanes>
+bool MyCompressor<SampleType>::computeControlRateGains(size_t firstChannel, const SampleType* frames, SampleType* gains,
+                                                       size_t numFrames, size_t phase, GainRamp ramp,
+                                                       SampleType& envelopePeak) noexcept
+{
+    // See processChannelGroup()
+    constexpr auto isMeanSquare = levelType != LevelCalculationType::peak;
+    constexpr auto needsSquareRoot = isMeanSquare && gainPrecision == GainComputerPrecision::exact;
+
+    const auto factor = controlRateFactor;
+    const auto factorInverse = static_cast<SampleType> (1.0) / static_cast<SampleType> (factor);
+    const auto unity = static_cast<SampleType> (1.0);
+
+    jassert(factor > 1 && phase < factor && numFrames <= kernelBlockSize);
+    jassert(firstChannel + numLanes <= controlLevels.size());
+
+    // A chunk completes at most one control period every two frames
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, kernelBlockSize / 2 * numLanes> control;
+
+    std::array<SampleType, numLanes> level, startGain, targetGain;
+    std::copy_n(controlLevels.begin() + (std::ptrdiff_t)firstChannel, numLanes, level.begin());
+    std::copy_n(controlStartGains.begin() + (std::ptrdiff_t)firstChannel, numLanes, startGain.begin());
+    std::copy_n(controlTargetGains.begin() + (std::ptrdiff_t)firstChannel, numLanes, targetGain.begin());
+
+    // Peak preserving decimation: the peak of the key over every control
+    // period, or its RMS for the RMS detectors, which square it again. The
+    // chunk is walked in runs that end with a control period or with the chunk.
+    size_t numControlValues = 0;
+
+    for (size_t i = 0, position = phase; i < numFrames;)
+    {
+        const auto runEnd = juce::jmin(numFrames, i + factor - position);
+
+        for (; i < runEnd; ++i, ++position)
+        {
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                const auto x = frames[i * numLanes + lane];
+                level[lane] = isMeanSquare ? level[lane] + x * x : juce::jmax(level[lane], std::abs(x));
+            }
+        }
+
+        if (position == factor)
+        {
+            position = 0;
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                control[numControlValues * numLanes + lane] = isMeanSquare ? std::sqrt(level[lane] * factorInverse) : level[lane];
+                level[lane] = static_cast<SampleType> (0.0);
+            }
+
+            ++numControlValues;
+        }
+    }
+
+    std::copy(level.begin(), level.end(), controlLevels.begin() + (std::ptrdiff_t)firstChannel);
+
+    // Detector and gain computer, once per control period
+    const auto numValues = numControlValues * numLanes;
+
+    if constexpr (numLanes == 1)
+        controlFilter.processEnvelope(firstChannel, control.data(), control.data(), numControlValues);
+    else
+        controlFilter.processEnvelopeLanes(firstChannel, control.data(), control.data(), numControlValues);
+
+    auto peak = static_cast<SampleType> (0.0);
+
+    for (size_t i = 0; i < numValues; ++i)
+        peak = juce::jmax(peak, control[i]);
+
+    envelopePeak = juce::jmax(envelopePeak, peak);
+
+    // Bypassed, the gain is 1 and the interpolation starts from there again
+    // when the bypass is switched off
+    if (bypassFade.isDetectorOnly())
+    {
+        std::fill(controlStartGains.begin() + (std::ptrdiff_t)firstChannel,
+                  controlStartGains.begin() + (std::ptrdiff_t)(firstChannel + numLanes), unity);
+        std::fill(controlTargetGains.begin() + (std::ptrdiff_t)firstChannel,
+                  controlTargetGains.begin() + (std::ptrdiff_t)(firstChannel + numLanes), unity);
+        return true;
+    }
+
+    const auto isRamping = ramp.numSamplesRemaining > 0;
+    const auto isBelow = ! isRamping && isBelowThreshold<isMeanSquare>(peak);
+
+    // Below the threshold with a settled interpolation the gain stays 1 for
+    // the whole chunk, and gains is left untouched
+    const auto isSettled = [&]
+    {
+        for (size_t lane = 0; lane < numLanes; ++lane)
+            if (startGain[lane] != unity || targetGain[lane] != unity)
+                return false;
+
+        return true;
+    };
+
+    if (isBelow && isSettled())
+        return true;
+
+    if (isBelow)
+    {
+        std::fill_n(control.begin(), numValues, unity);
+    }
+    else
+    {
+        if constexpr (needsSquareRoot)
+            for (size_t i = 0; i < numValues; ++i)
+                control[i] = std::sqrt(control[i]);
+
+        if (isRamping)
+        {
+            // Each control value takes the ramp from the frame that completed its period
+            advanceRamp(ramp, factor - 1 - phase);
+            computeGainRamped<gainPrecision, isMeanSquare && ! needsSquareRoot>(control.data(), numControlValues, numLanes, ramp, factor);
+        }
+        else
+        {
+            computeGain<gainPrecision, isMeanSquare && ! needsSquareRoot>(control.data(), numValues);
+        }
+    }
+
+    // Back to the audio rate: every new gain is reached linearly over the
+    // control period that follows the one it measured. With a power of two
+    // decimation the last frame of a period lands exactly on its target, so a
+    // gain of 1 stays exactly 1.
+    for (size_t i = 0, position = phase, k = 0; i < numFrames;)
+    {
+        const auto runEnd = juce::jmin(numFrames, i + factor - position);
+
+        for (; i < runEnd; ++i, ++position)
+        {
+            const auto fraction = static_cast<SampleType> (position + 1) * factorInverse;
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+                gains[i * numLanes + lane] = startGain[lane] + (targetGain[lane] - startGain[lane]) * fraction;
+        }
+
+        if (position == factor)
+        {
+            position = 0;
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                startGain[lane] = targetGain[lane];
+                targetGain[lane] = control[k * numLanes + lane];
+            }
+
+            ++k;
+        }
+    }
+
+    std::copy(startGain.begin(), startGain.end(), controlStartGains.begin() + (std::ptrdiff_t)firstChannel);
+    std::copy(targetGain.begin(), targetGain.end(), controlTargetGains.begin() + (std::ptrdiff_t)firstChannel);
+
+    return false;
+}
+
+template <typename SampleType>
+template <bool isMeanSquare>
+bool MyCompressor<SampleType>::isBelowThreshold(SampleType envelopePeak) const noexcept
+{
+    // Below the threshold both gain computers return exactly 1. The linear
+    // threshold is compared with the envelope as the detector produced it.
+    return envelopePeak < (isMeanSquare ? threshold * threshold : threshold);
+}
+
+template <typename SampleType>
+bool MyCompressor<SampleType>::isSilentBlock(const juce::dsp::AudioBlock<const SampleType>& keyBlock) noexcept
+{
+    const auto silenceLevel = static_cast<SampleType> (MyEnvelopeDetector<SampleType>::silenceLevel);
+    const auto keyRange = keyBlock.findMinAndMax();
+    const auto keyPeak = juce::jmax(-keyRange.getStart(), keyRange.getEnd());
+
+    // The lookahead windows only hold silence once the key has been silent
+    // for as long as the delay
+    const auto wasSilentFor = numSilentKeySamples;
+    const auto maximumCount = (size_t)juce::roundToInt(MyCompressorParameters::maximumLookaheadTime * 0.001 * sampleRate) + 1;
+
+    numSilentKeySamples = keyPeak <= silenceLevel ? juce::jmin(maximumCount, numSilentKeySamples + keyBlock.getNumSamples()) : 0;
+
+    if (keyPeak > silenceLevel || wasSilentFor < (size_t)lookahead.getDelay())
+        return false;
+
+    // The threshold may still be ramping from gainRamp.thresholddB
+    const auto silenceLeveldB = static_cast<SampleType> (MyEnvelopeDetector<SampleType>::silenceLeveldB);
+
+    if (juce::jmin(thresholddB, gainRamp.thresholddB) <= silenceLeveldB)
+        return false;
+
+    // Only the detector of the current rate runs
+    const auto isDecimated = controlRateFactor > 1;
+    const auto& detector = isDecimated ? controlFilter : envelopeFilter;
+
+    if (! detector.isSilent() || (sidechainFilter.isEnabled() && ! sidechainFilter.isSilent(silenceLevel)))
+        return false;
+
+    // In the control rate mode the interpolated gain must also have reached 1
+    if (isDecimated)
+    {
+        const auto isUnity = [](SampleType gain) { return gain == static_cast<SampleType> (1.0); };
+
+        if (! std::all_of(controlStartGains.begin(), controlStartGains.end(), isUnity)
+             || ! std::all_of(controlTargetGains.begin(), controlTargetGains.end(), isUnity))
+            return false;
+    }
+
+    meterInputPeak = keyPeak;
+    return true;
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::finishBlock(size_t numSamples) noexcept
+{
+    advanceRamp(gainRamp, numSamples);
+    controlPhase = (controlPhase + numSamples) % controlRateFactor;
+
+    if (bypassFade.numSamplesRemaining > 0)
+    {
+        const auto numFadeSamples = juce::jmin(numSamples, bypassFade.numSamplesRemaining);
+
+        bypassFade.wet += bypassFade.wetStep * static_cast<SampleType> (numFadeSamples);
+        bypassFade.numSamplesRemaining -= numFadeSamples;
+
+        // Lands exactly on the end, so that the bypassed gain is exactly 1
+        if (bypassFade.numSamplesRemaining == 0)
+            bypassFade.wet = static_cast<SampleType> (bypassFade.isBypassed ? 0.0 : 1.0);
+    }
+
+#if JUCE_DSP_ENABLE_SNAP_TO_ZERO
+    envelopeFilter.snapToZero();
+    controlFilter.snapToZero();
+#endif
+
+    meterValues.inputPeak = static_cast<float> (meterInputPeak);
+    meterValues.envelopePeak = static_cast<float> (meterEnvelopePeak);
+    meterValues.minimumGain = static_cast<float> (meterMinimumGain);
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::startBypassFade(bool shouldBypass) noexcept
+{
+    bypassFade.isBypassed = shouldBypass;
+
+    // A fade reversed halfway takes half as long to return
+    const auto target = static_cast<SampleType> (shouldBypass ? 0.0 : 1.0);
+    const auto distance = std::abs(target - bypassFade.wet);
+
+    bypassFade.numSamplesRemaining = (size_t)juce::roundToInt(distance * static_cast<SampleType> (bypassFadeSamples));
+
+    if (bypassFade.numSamplesRemaining == 0)
+    {
+        bypassFade.wet = target;
+        bypassFade.wetStep = static_cast<SampleType> (0.0);
+        return;
+    }
+
+    bypassFade.wetStep = (target - bypassFade.wet) / static_cast<SampleType> (bypassFade.numSamplesRemaining);
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::applyBypassFade(SampleType* gains, size_t numLanes, size_t start,
+                                               size_t firstFrame, size_t lastFrame) const noexcept
+{
+    const auto one = static_cast<SampleType> (1.0);
+    const auto target = static_cast<SampleType> (bypassFade.isBypassed ? 0.0 : 1.0);
+
+    for (size_t i = firstFrame; i < lastFrame; ++i)
+    {
+        // The wet level after sample start + i of the block
+        const auto position = start + i + 1;
+        const auto wet = position < bypassFade.numSamplesRemaining
+                       ? bypassFade.wet + bypassFade.wetStep * static_cast<SampleType> (position)
+                       : target;
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+            gains[i * numLanes + lane] = one + wet * (gains[i * numLanes + lane] - one);
+    }
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::processBypassedLookahead(const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                                                        const juce::dsp::AudioBlock<SampleType>& outputBlock) noexcept
+{
+    const auto numSamples = outputBlock.getNumSamples();
+
+    for (size_t channel = 0; channel < outputBlock.getNumChannels(); ++channel)
+    {
+        const auto* input = inputBlock.getChannelPointer(channel);
+        auto* output = outputBlock.getChannelPointer(channel);
+
+        for (size_t start = 0; start < numSamples; start += kernelBlockSize)
+            lookahead.processDelay(channel, input + start, output + start, juce::jmin(kernelBlockSize, numSamples - start));
+    }
+}
+
+template <typename SampleType>
+template <GainComputerPrecision gainPrecision, bool isMeanSquare>
+void MyCompressor<SampleType>::computeGain(SampleType* envelope, size_t numValues) const noexcept
+{
+    // A mean square envelope is only supported by the fast gain computer
+    static_assert(! isMeanSquare || gainPrecision == GainComputerPrecision::fast);
+
+    if constexpr (gainPrecision == GainComputerPrecision::fast)
+    {
+        // Local copies: the stores to envelope could alias the members.
+        // log2 (sqrt (x)) == log2 (x) / 2, so a mean square needs twice the
+        // threshold and half the slope.
+        constexpr auto scale = static_cast<SampleType> (isMeanSquare ? 2.0 : 1.0);
+        const auto log2Thr = log2Threshold * scale;
+        const auto slopeValue = slope / scale;
+
+        for (size_t i = 0; i < numValues; ++i)
+            envelope[i] = computeGainFast(envelope[i], log2Thr, slopeValue);
+    }
+    else
+    {
+        const auto thrdB = thresholddB, ratioInv = ratioInverse;
+
+        for (size_t i = 0; i < numValues; ++i)
+            envelope[i] = computeGainExact(envelope[i], thrdB, ratioInv);
+    }
+}
+
+template <typename SampleType>
+template <GainComputerPrecision gainPrecision, bool isMeanSquare>
+void MyCompressor<SampleType>::computeGainRamped(SampleType* envelope, size_t numFrames, size_t numLanes, GainRamp& ramp,
+                                                 size_t framesPerValue) const noexcept
+{
+    static_assert(! isMeanSquare || gainPrecision == GainComputerPrecision::fast);
+
+    // Per frame threshold and slope, shared by all lanes
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, kernelBlockSize> thrdB, ratioInv;
+    jassert(numFrames <= kernelBlockSize);
+
+    for (size_t i = 0; i < numFrames; ++i)
+    {
+        thrdB[i] = ramp.thresholddB;
+        ratioInv[i] = ramp.ratioInverse;
+        advanceRamp(ramp, framesPerValue);
+    }
+
+    if constexpr (gainPrecision == GainComputerPrecision::fast)
+    {
+        constexpr auto scale = static_cast<SampleType> (isMeanSquare ? 2.0 : 1.0);
+
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            const auto log2Thr = thrdB[i] * scale / static_cast<SampleType> (6.020599913279624);
+            const auto slopeValue = (ratioInv[i] - static_cast<SampleType> (1.0)) / scale;
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+                envelope[i * numLanes + lane] = computeGainFast(envelope[i * numLanes + lane], log2Thr, slopeValue);
+        }
+    }
+    else
+    {
+        for (size_t i = 0; i < numFrames; ++i)
+            for (size_t lane = 0; lane < numLanes; ++lane)
+                envelope[i * numLanes + lane] = computeGainExact(envelope[i * numLanes + lane], thrdB[i], ratioInv[i]);
+    }
+}
+
+template <typename SampleType>
+void MyCompressor<SampleType>::advanceRamp(GainRamp& ramp, size_t numSamples) const noexcept
+{
+    if (ramp.numSamplesRemaining == 0)
+        return;
+
+    if (numSamples >= ramp.numSamplesRemaining)
+    {
+        // Land exactly on the target
+        ramp = GainRamp();
+        ramp.thresholddB = thresholddB;
+        ramp.ratioInverse = ratioInverse;
+        return;
+    }
+
+    const auto n = static_cast<SampleType> (numSamples);
+    ramp.thresholddB += ramp.thresholddBStep * n;
+    ramp.ratioInverse += ramp.ratioInverseStep * n;
+    ramp.numSamplesRemaining -= numSamples;
 }
 
 template <typename SampleType>
 void MyCompressor<SampleType>::setRCMode(int mode) {
-    envelopeFilter.setTC(mode);
+    if (rcMode != mode) {
+        rcMode = mode;
+        update();
+    }
 }
 
 template <typename SampleType>
 void MyCompressor<SampleType>::update()
 {
-    threshold = juce::Decibels::decibelsToGain(thresholddB, minus_inf);
-    //DBG(threshold);
-    thresholdInverse = static_cast<SampleType> (1.0) / threshold;
-    ratioInverse = static_cast<SampleType> (1.0) / ratio;
-
-    envelopeFilter.setAttackTime(attackTime);
-    envelopeFilter.setReleaseTime(releaseTime);
+    setCoefficients(MyCompressorCoefficients::calculate(getParameters(), sampleRate));
 }
 
 //==============================================================================
@@ -23,9 +23,40 @@
   ==============================================================================
 */
 
+#pragma once
+
 #include <iostream>
 #include <JuceHeader.h>
 #include "MyEnvelopeDetector.h"
+#include "MyFastMath.h"
+#include "MyLookahead.h"
+#include "MySidechainFilter.h"
+#include "MyCompressorCoefficients.h"
+#include "MyCpuDispatch.h"
+
+enum class GainComputerPrecision
+{
+    exact,
+    fast
+};
+
+enum class ChannelLinkMode
+{
+    none,
+    max,
+    mean,
+    weighted
+};
+
+/** Levels measured over one processed block, for metering. All values are
+    linear gains.
+*/
+struct MyCompressorMeterValues
+{
+    float inputPeak = 0.0f;     // the detector input, so the lookahead peak when that is on
+    float envelopePeak = 0.0f;
+    float minimumGain = 1.0f;   // the largest gain reduction
+};
 
 /**
 A simple compressor with standard threshold, ratio, attack time and release time
@@ -55,58 +86,422 @@ public:
     /** Sets the release time in milliseconds of the compressor.*/
     void setRelease(SampleType newRelease);
 
+    /** Sets the lookahead time in milliseconds, from 0 up to
+        MyCompressorParameters::maximumLookaheadTime.
+
+        The audio is delayed by the lookahead time while the detector is fed
+        the peak level over the window from the delayed sample up to the newest
+        one, so the gain is already reduced when a transient reaches the output.
+        The delay is the latency of the compressor, see getLatencySamples().
+    */
+    void setLookahead(SampleType newLookahead);
+
+    /** Returns the latency in samples introduced by the lookahead. */
+    int getLatencySamples() const noexcept;
+
+    /** Returns how long the compressor keeps working after its input stops:
+        the lookahead delay plus the time the envelope needs to release to
+        silence (see MyEnvelopeDetector::getDecayTime()). A host that suspends
+        processing after this tail resumes with the detector at rest.
+    */
+    double getTailLengthSeconds() const noexcept;
+
+    /** Sets how the envelope detector measures the level (peak, RMS or windowed
+        RMS). Changing the type resets the envelope.
+    */
+    void setLevelCalculationType(BallisticsFilterLevelCalculationType newType);
+
+    /** Sets the window length in milliseconds of the windowed RMS detector, up
+        to MyEnvelopeDetector::maximumRMSWindowTime.
+    */
+    void setRMSWindow(SampleType newRMSWindow);
+
+    /** Sets the filter on the detector's key signal, with its centre or cutoff
+        frequency in Hz and its Q. The key is the input, or the sidechain when
+        one is passed to process().
+    */
+    void setSidechainFilter(SidechainFilterType newType, SampleType newFrequency, SampleType newQ);
+
+    /** Sets how the gain computer converts between the linear and the log domain.
+
+        GainComputerPrecision::exact uses juce::Decibels (log10 and pow) and is the
+        reference. GainComputerPrecision::fast uses the polynomial approximations of
+        MyFastMath, which keep the gain within 0.0005 dB of the reference for a
+        fraction of the cost.
+    */
+    void setPrecision(GainComputerPrecision newPrecision);
+
+    /** Enables the control rate mode, see MyCompressorCoefficients::controlRateFactor.
+
+        The detector and the gain computer then run once every N samples, on
+        the peak (or for the RMS detectors the RMS) of the key over those N
+        samples, and the gain is interpolated linearly back to the audio rate.
+        Each new gain is reached one control period after the last key sample
+        it measured, so the gain trails the full rate one by up to 2 N samples.
+        The peak of a control period is at least every sample in it, so the
+        peak detector errs towards more gain reduction, never less. At sample
+        rates up to 48 kHz, or with attack times too short to leave 8 control
+        periods, N is 1 and nothing changes.
+    */
+    void setControlRate(bool shouldUseControlRate);
+
+    /** Sets how the channels are linked.
+
+        With ChannelLinkMode::none every channel has its own envelope and gain.
+        The other modes combine the rectified inputs of all channels into one
+        detector signal (their maximum, mean or weighted sum), run a single
+        envelope and gain computation per sample frame and apply the resulting
+        gain to every channel, which keeps the stereo image stable.
+    */
+    void setLinkMode(ChannelLinkMode newLinkMode);
+
+    /** Sets the weight of a channel for ChannelLinkMode::weighted. All weights
+        default to 1.0 and are reset by prepare().
+    */
+    void setLinkWeight(int channel, SampleType newWeight);
+
+    /** Applies a complete set of coefficients computed with
+        MyCompressorCoefficients::calculate().
+
+        This only copies values and performs no transcendental math, so it is the
+        way to change the settings from the audio thread. The individual setters
+        recompute the coefficients and should be called away from it.
+    */
+    void setCoefficients(const MyCompressorCoefficients& newCoefficients) noexcept;
+
+    /** Applies a set of coefficients, ramping the threshold and the ratio towards
+        their new values over the next numRampSamples samples.
+
+        The threshold is ramped linearly in dB (so exponentially in amplitude) and
+        the ratio linearly as 1 / ratio, which is the slope of the static curve.
+        The ramp runs inside the block kernel of process(); processSample() uses
+        the target values. The attack and release coefficients change at once.
+    */
+    void setCoefficients(const MyCompressorCoefficients& newCoefficients, int numRampSamples) noexcept;
+
+    /** Returns the current settings of the compressor. */
+    MyCompressorParameters getParameters() const noexcept;
+
+    /** Returns the gain of the static curve for a detector level, with the
+        current threshold, ratio and precision, as the block kernels compute
+        it. With isMeanSquare the fast gain computer gets the square of the
+        level, as it does behind the RMS detectors. This is how
+        CompressorBenchmark --verify measures the error of the fast one.
+    */
+    SampleType computeStaticGain(SampleType level, bool isMeanSquare) const noexcept;
+
     //==============================================================================
-    /** Initialises the processor. */
+    /** Initialises the processor, and picks the instruction set of the block
+        kernels (see MyCpuDispatch).
+    */
     void prepare(const juce::dsp::ProcessSpec& spec);
 
+    /** Returns the instruction set the block kernels were compiled for, as
+        picked by the last call to prepare().
+    */
+    InstructionSet getInstructionSet() const noexcept { return instructionSet; }
+
     /** Resets the internal state variables of the processor. */
     void reset();
 
     //==============================================================================
-    /** Processes the input and output samples supplied in the processing context. */
+    /** Processes the input and output samples supplied in the processing context.
+
+        Channels are processed side by side, one channel per SIMD lane, in
+        chunks of kernelBlockSize samples. The kernel performs the same
+        arithmetic as processSample(), so both paths agree to within 1 ulp of
+        the envelope (they are bit-identical unless the compiler contracts the
+        detector's multiply-add differently for the two loops).
+    */
     template <typename ProcessContext>
     void process(const ProcessContext& context) noexcept
+    {
+        process(context, context.getInputBlock());
+    }
+
+    /** Processes the samples supplied in the processing context, with the
+        detector keyed from a separate sidechain block.
+
+        The sidechain is read where it is, never copied. It must have as many
+        samples as the context and at least one channel; channel c of the
+        output is keyed from sidechain channel c modulo the number of sidechain
+        channels, so a mono sidechain keys every channel. Passing the input
+        block itself gives the same result as process(context).
+
+        Switching context.isBypassed crossfades over bypassFadeTime. While
+        bypassed only the key filter, the lookahead and the detector run, and
+        an in-place context is not copied, so the envelope is current when
+        the bypass is switched off.
+    */
+    template <typename ProcessContext>
+    void process(const ProcessContext& context, const juce::dsp::AudioBlock<const SampleType>& sidechainBlock) noexcept
     {
         const auto& inputBlock = context.getInputBlock();
         auto& outputBlock = context.getOutputBlock();
         const auto numChannels = outputBlock.getNumChannels();
         const auto numSamples = outputBlock.getNumSamples();
+        const auto numKeyChannels = sidechainBlock.getNumChannels();
 
         jassert(inputBlock.getNumChannels() == numChannels);
         jassert(inputBlock.getNumSamples() == numSamples);
+        jassert(numKeyChannels > 0 && sidechainBlock.getNumSamples() == numSamples);
+
+        meterInputPeak = meterEnvelopePeak = static_cast<SampleType> (0.0);
+        meterMinimumGain = static_cast<SampleType> (1.0);
+        meterValues = MyCompressorMeterValues();
+
+        // Bypassing crossfades to the dry signal, which is still delayed by
+        // the lookahead since the host compensates for the latency. Once
+        // bypassed the kernels only run the detector, so the envelope is
+        // current when the bypass is switched off again.
+        if (context.isBypassed != bypassFade.isBypassed)
+            startBypassFade(context.isBypassed);
 
-        if (context.isBypassed)
+        // Silence fast path: with a silent key and a decayed detector the gain
+        // is exactly 1, so the audio only passes through the lookahead delay
+        if (isSilentBlock(sidechainBlock))
         {
-            outputBlock.copyFrom(inputBlock);
+            if (lookahead.getDelay() > 0)
+                processBypassedLookahead(inputBlock, outputBlock);
+            else if (inputBlock.getChannelPointer(0) != outputBlock.getChannelPointer(0))
+                outputBlock.copyFrom(inputBlock);
+
+            finishBlock(numSamples);
             return;
         }
 
-        for (size_t channel = 0; channel < numChannels; ++channel)
+        // The kernels specialised for the current level type and precision
+        const auto kernels = getKernels();
+
+        if (linkMode != ChannelLinkMode::none)
         {
-            auto* inputSamples = inputBlock.getChannelPointer(channel);
-            auto* outputSamples = outputBlock.getChannelPointer(channel);
+            (this->*kernels.linked)(inputBlock, sidechainBlock, outputBlock);
+            finishBlock(numSamples);
+            return;
+        }
 
-            for (size_t i = 0; i < numSamples; ++i)
-                outputSamples[i] = processSample((int)channel, inputSamples[i]);
+        for (size_t firstChannel = 0; firstChannel < numChannels; firstChannel += SIMDType::size())
+        {
+            const auto numLanes = juce::jmin(SIMDType::size(), numChannels - firstChannel);
+
+            std::array<const SampleType*, SIMDType::size()> inputs{}, keys{};
+            std::array<SampleType*, SIMDType::size()> outputs{};
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                inputs[lane] = inputBlock.getChannelPointer(firstChannel + lane);
+                keys[lane] = sidechainBlock.getChannelPointer((firstChannel + lane) % numKeyChannels);
+                outputs[lane] = outputBlock.getChannelPointer(firstChannel + lane);
+            }
+
+            (this->*kernels.channelGroup)(firstChannel, numLanes, inputs.data(), keys.data(), outputs.data(), numSamples);
         }
+
+        finishBlock(numSamples);
     }
 
-    /** Performs the processing operation on a single sample at a time. */
+    /** Returns the levels measured during the last call to process(). */
+    MyCompressorMeterValues getMeterValues() const noexcept { return meterValues; }
+
+    /** The length in ms of the crossfade when the bypass of the processing
+        context is switched on or off.
+    */
+    static constexpr double bypassFadeTime = 10.0;
+
+    /** Performs the processing operation on a single sample at a time.
+        This does not apply the lookahead.
+    */
     SampleType processSample(int channel, SampleType inputValue);
 
     void setRCMode(int mode);
 
 private:
+    //==============================================================================
+    using SIMDType = typename MyEnvelopeDetector<SampleType>::SIMDType;
+
+    /** Number of samples per channel the block kernel works on at a time. */
+    static constexpr size_t kernelBlockSize = 64;
+
+    /** Number of sample frames over which the kernels decide whether the
+        envelope stays below the threshold, so that the gain computer and the
+        VCA can be skipped.
+    */
+    static constexpr size_t gainSegmentSize = 16;
+
+    using LevelCalculationType = BallisticsFilterLevelCalculationType;
+
+    template <LevelCalculationType levelType, GainComputerPrecision gainPrecision, bool isDecimated>
+    void processChannelGroup(size_t firstChannel, size_t numLanes,
+                             const SampleType* const* inputs, const SampleType* const* keys,
+                             SampleType* const* outputs, size_t numSamples) noexcept;
+
+    /** The gain computer settings while a threshold or ratio ramp is running. */
+    struct GainRamp
+    {
+        SampleType thresholddB = 0.0, ratioInverse = 1.0;
+        SampleType thresholddBStep = 0.0, ratioInverseStep = 0.0;
+        size_t numSamplesRemaining = 0;
+    };
+
+    template <LevelCalculationType levelType, GainComputerPrecision gainPrecision, bool isDecimated>
+    void processLinked(const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                       const juce::dsp::AudioBlock<const SampleType>& keyBlock,
+                       const juce::dsp::AudioBlock<SampleType>& outputBlock) noexcept;
+
+    /** The control rate gain stage of the kernels: decimates numFrames
+        interleaved frames of numLanes lanes, runs the control rate detector
+        and gain computer once per completed control period and writes the
+        gain, interpolated to every frame, to gains. The control rate state of
+        the lanes starts at firstChannel. Raises envelopePeak to the largest
+        control rate envelope, a mean square for the RMS detectors.
+
+        Returns true, leaving gains untouched, if the gain is exactly 1 for the
+        whole chunk.
+    */
+    template <LevelCalculationType levelType, GainComputerPrecision gainPrecision, size_t numLanes>
+    bool computeControlRateGains(size_t firstChannel, const SampleType* frames, SampleType* gains,
+                                 size_t numFrames, size_t phase, GainRamp ramp, SampleType& envelopePeak) noexcept;
+
+    /** The entry points of the block kernels for one instruction set: the
+        kernels above, inlined into code compiled for it (see MyCpuDispatch).
+    */
+    template <InstructionSet isa, LevelCalculationType levelType, GainComputerPrecision gainPrecision, bool isDecimated>
+    void processChannelGroupFor(size_t firstChannel, size_t numLanes,
+                                const SampleType* const* inputs, const SampleType* const* keys,
+                                SampleType* const* outputs, size_t numSamples) noexcept;
+
+    template <InstructionSet isa, LevelCalculationType levelType, GainComputerPrecision gainPrecision, bool isDecimated>
+    void processLinkedFor(const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                          const juce::dsp::AudioBlock<const SampleType>& keyBlock,
+                          const juce::dsp::AudioBlock<SampleType>& outputBlock) noexcept;
+
+    /** The instantiations of the block kernels for one combination of
+        instruction set, level calculation type, gain computer precision and
+        control rate. These are fixed for a whole block, so every branch on
+        them is resolved at compile time and the inner loops are left free to
+        vectorise.
+    */
+    struct Kernels
+    {
+        void (MyCompressor::*channelGroup)(size_t, size_t, const SampleType* const*, const SampleType* const*,
+                                           SampleType* const*, size_t) noexcept;
+        void (MyCompressor::*linked)(const juce::dsp::AudioBlock<const SampleType>&,
+                                     const juce::dsp::AudioBlock<const SampleType>&,
+                                     const juce::dsp::AudioBlock<SampleType>&) noexcept;
+    };
+
+    template <InstructionSet isa, LevelCalculationType levelType, GainComputerPrecision gainPrecision, bool isDecimated>
+    static constexpr Kernels makeKernels() noexcept
+    {
+        return { &MyCompressor::processChannelGroupFor<isa, levelType, gainPrecision, isDecimated>,
+                 &MyCompressor::processLinkedFor<isa, levelType, gainPrecision, isDecimated> };
+    }
+
+    /** Looks up the kernels for the current settings, once per block. */
+    Kernels getKernels() const noexcept;
+
+    template <InstructionSet isa>
+    Kernels getKernelsFor() const noexcept;
+
+    /** Returns true if an envelope peak, a mean square for the RMS detectors
+        in the kernels, is below the threshold.
+    */
+    template <bool isMeanSquare>
+    bool isBelowThreshold(SampleType envelopePeak) const noexcept;
+
+    /** Updates the count of silent key samples with a new block and returns
+        true if the block can skip the detector and the gain computer: its key
+        is below MyEnvelopeDetector::silenceLevel and has been so for the whole
+        lookahead window, the envelope and key filter have decayed (and in the
+        control rate mode the interpolated gain has reached 1), and the
+        threshold is above the silence level so the gain stays exactly 1.
+    */
+    bool isSilentBlock(const juce::dsp::AudioBlock<const SampleType>& keyBlock) noexcept;
+
+    /** Advances the ramp, the bypass crossfade and the control period, snaps
+        the detector state to zero and publishes the meter values, once per
+        processed block.
+    */
+    void finishBlock(size_t numSamples) noexcept;
+
+    /** The crossfade between the compressed signal (wet = 1) and the bypassed
+        one (wet = 0). It is applied to the gain, as 1 + wet * (gain - 1), so
+        it needs no copy of the dry signal.
+    */
+    struct BypassFade
+    {
+        SampleType wet = 1.0, wetStep = 0.0;
+        size_t numSamplesRemaining = 0;
+        bool isBypassed = false;
+
+        /** True once the fade to the bypassed signal has ended: the kernels
+            then skip the gain computer and the VCA.
+        */
+        bool isDetectorOnly() const noexcept { return isBypassed && numSamplesRemaining == 0; }
+    };
+
+    void startBypassFade(bool shouldBypass) noexcept;
+
+    /** Applies the bypass crossfade to the gains of frames [firstFrame, lastFrame)
+        of a chunk starting at sample start of the block, numLanes gains per frame.
+    */
+    void applyBypassFade(SampleType* gains, size_t numLanes, size_t start, size_t firstFrame, size_t lastFrame) const noexcept;
+
+    void processBypassedLookahead(const juce::dsp::AudioBlock<const SampleType>& inputBlock,
+                                  const juce::dsp::AudioBlock<SampleType>& outputBlock) noexcept;
+
+    template <GainComputerPrecision gainPrecision, bool isMeanSquare>
+    void computeGain(SampleType* envelope, size_t numValues) const noexcept;
+
+    /** Computes the gain of numFrames frames while the threshold or the ratio
+        ramps, advancing the ramp by framesPerValue samples per frame.
+    */
+    template <GainComputerPrecision gainPrecision, bool isMeanSquare>
+    void computeGainRamped(SampleType* envelope, size_t numFrames, size_t numLanes, GainRamp& ramp,
+                           size_t framesPerValue = 1) const noexcept;
+    void advanceRamp(GainRamp& ramp, size_t numSamples) const noexcept;
+
+    SampleType computeGainExact(SampleType envelope, SampleType thrdB, SampleType ratioInv) const noexcept;
+    static forcedinline SampleType computeGainFast(SampleType envelope, SampleType log2Thr, SampleType slopeValue) noexcept;
+
     //==============================================================================
     void update();
 
     //==============================================================================
-    SampleType threshold, thresholdInverse, ratioInverse;
+    SampleType threshold, thresholdInverse, ratioInverse, log2Threshold, slope;
     MyEnvelopeDetector<SampleType> envelopeFilter;
+    MyEnvelopeDetector<SampleType> controlFilter;
+    MyLookahead<SampleType> lookahead;
+    MySidechainFilter<SampleType> sidechainFilter;
 
     SampleType minus_inf = static_cast<SampleType> (-200.0);
 
     double sampleRate = 44100.0;
-    SampleType thresholddB = 0.0, ratio = 1.0, attackTime = 1.0, releaseTime = 100.0;
+    SampleType thresholddB = 0.0, ratio = 1.0, attackTime = 1.0, releaseTime = 100.0, lookaheadTime = 0.0;
+    SampleType rmsWindow = 300.0;
+    int rcMode = 0;
+    SidechainFilterType sidechainFilterType = SidechainFilterType::off;
+    SampleType sidechainFilterFrequency = 100.0, sidechainFilterQ = 0.7071;
+    GainComputerPrecision precision = GainComputerPrecision::exact;
+    InstructionSet instructionSet = InstructionSet::generic;
+    GainRamp gainRamp;
+    BypassFade bypassFade;
+    size_t bypassFadeSamples = 1;
+
+    // Control rate mode: the decimation and, per channel, the level over the
+    // running control period and the two gains the current one interpolates
+    // between. All channels share the position in the control period.
+    bool controlRate = false;
+    size_t controlRateFactor = 1, controlPhase = 0;
+    std::vector<SampleType> controlLevels, controlStartGains, controlTargetGains;
+
+    // Consecutive samples of silent key, up to the longest possible lookahead
+    size_t numSilentKeySamples = 0;
+
+    ChannelLinkMode linkMode = ChannelLinkMode::none;
+    std::vector<SampleType> linkWeights;
+
+    SampleType meterInputPeak = 0.0, meterEnvelopePeak = 0.0, meterMinimumGain = 1.0;
+    MyCompressorMeterValues meterValues;
     
 };
\ No newline at end of file
@@ -0,0 +1,292 @@
+#include <JuceHeader.h>
+#include "MyCompressorBank.h"
+
+// See MyCompressor.cpp: no fused multiply-adds, so that every instruction set
+// gives the same result
+#if JUCE_GCC
+ #pragma GCC optimize ("fp-contract=off")
+#elif JUCE_CLANG
+ #pragma STDC FP_CONTRACT OFF
+#endif
+
+//==============================================================================
+template <typename SampleType>
+void MyCompressorBank<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels > 0);
+
+    numChannels = spec.numChannels;
+    instructionSet = MyCpuDispatch::getInstructionSet();
+    groups.resize((numChannels + laneGroupSize - 1) / laneGroupSize);
+
+    setCoefficients(MyCompressorCoefficients());
+    reset();
+}
+
+template <typename SampleType>
+void MyCompressorBank<SampleType>::reset() noexcept
+{
+    for (auto& group : groups)
+    {
+        group.state.fill(static_cast<SampleType> (0.0));
+        group.minimumGain.fill(static_cast<SampleType> (1.0));
+    }
+}
+
+template <typename SampleType>
+SampleType MyCompressorBank<SampleType>::getMinimumGain(int channel) const noexcept
+{
+    jassert(juce::isPositiveAndBelow(channel, (int)numChannels));
+    return groups[(size_t)channel / laneGroupSize].minimumGain[(size_t)channel % laneGroupSize];
+}
+
+//==============================================================================
+template <typename SampleType>
+void MyCompressorBank<SampleType>::setChannelCoefficients(int channel, const MyCompressorCoefficients& newCoefficients) noexcept
+{
+    jassert(juce::isPositiveAndBelow(channel, (int)numChannels));
+    setLaneCoefficients(groups[(size_t)channel / laneGroupSize], (size_t)channel % laneGroupSize, newCoefficients);
+}
+
+template <typename SampleType>
+void MyCompressorBank<SampleType>::setCoefficients(const MyCompressorCoefficients& newCoefficients) noexcept
+{
+    // The unused lanes of the last group get them too, which is harmless:
+    // their input is silent
+    for (auto& group : groups)
+        for (size_t lane = 0; lane < laneGroupSize; ++lane)
+            setLaneCoefficients(group, lane, newCoefficients);
+}
+
+template <typename SampleType>
+void MyCompressorBank<SampleType>::setLaneCoefficients(LaneGroup& group, size_t lane, const MyCompressorCoefficients& newCoefficients) noexcept
+{
+    const auto& c = newCoefficients;
+
+    group.cteAT[lane] = static_cast<SampleType> (c.cteAT);
+    group.cteRL[lane] = static_cast<SampleType> (c.cteRL);
+    group.thresholddB[lane] = static_cast<SampleType> (c.parameters.thresholddB);
+    group.ratioInverse[lane] = static_cast<SampleType> (c.ratioInverse);
+    group.log2Threshold[lane] = static_cast<SampleType> (c.log2Threshold);
+    group.slope[lane] = static_cast<SampleType> (c.slope);
+
+    // A ratio of 1 never reduces the gain, so such a lane always skips the
+    // gain computer, as if its threshold were infinite
+    const auto threshold = c.ratioInverse < 1.0 ? c.threshold : (double)std::numeric_limits<SampleType>::max();
+    group.levelThreshold[lane] = static_cast<SampleType> (levelType == LevelCalculationType::peak
+                                                          ? threshold
+                                                          : juce::jmin(threshold * threshold, (double)std::numeric_limits<SampleType>::max()));
+}
+
+template <typename SampleType>
+void MyCompressorBank<SampleType>::setLevelCalculationType(LevelCalculationType newType) noexcept
+{
+    // The windowed RMS detector needs a window per channel, use MyCompressor
+    jassert(newType != LevelCalculationType::windowedRMS);
+
+    if (newType == levelType)
+        return;
+
+    // The level thresholds are stored in the detector's units
+    const auto wasPeak = levelType == LevelCalculationType::peak;
+    levelType = newType;
+
+    for (auto& group : groups)
+    {
+        for (auto& threshold : group.levelThreshold)
+        {
+            const auto isFinite = threshold < std::numeric_limits<SampleType>::max();
+
+            if (isFinite)
+                threshold = wasPeak ? threshold * threshold : std::sqrt(threshold);
+        }
+    }
+
+    reset();
+}
+
+template <typename SampleType>
+void MyCompressorBank<SampleType>::setPrecision(GainComputerPrecision newPrecision) noexcept
+{
+    precision = newPrecision;
+}
+
+//==============================================================================
+template <typename SampleType>
+typename MyCompressorBank<SampleType>::Kernel MyCompressorBank<SampleType>::getKernel() const noexcept
+{
+#if MY_CPU_DISPATCH
+    switch (instructionSet)
+    {
+        case InstructionSet::avx2:      return getKernelFor<InstructionSet::avx2>();
+        case InstructionSet::avx512:    return getKernelFor<InstructionSet::avx512>();
+        case InstructionSet::generic:
+        default:                        break;
+    }
+#endif
+
+    return getKernelFor<InstructionSet::generic>();
+}
+
+template <typename SampleType>
+template <InstructionSet isa>
+typename MyCompressorBank<SampleType>::Kernel MyCompressorBank<SampleType>::getKernelFor() const noexcept
+{
+    using Type = LevelCalculationType;
+    using Precision = GainComputerPrecision;
+
+    // Indexed by level calculation type, then by precision. The windowed RMS
+    // type is not supported and runs as plain RMS.
+    static constexpr Kernel kernels[3][2] = {
+        { &MyCompressorBank::processGroupFor<isa, Type::peak, Precision::exact>, &MyCompressorBank::processGroupFor<isa, Type::peak, Precision::fast> },
+        { &MyCompressorBank::processGroupFor<isa, Type::RMS, Precision::exact>, &MyCompressorBank::processGroupFor<isa, Type::RMS, Precision::fast> },
+        { &MyCompressorBank::processGroupFor<isa, Type::RMS, Precision::exact>, &MyCompressorBank::processGroupFor<isa, Type::RMS, Precision::fast> }
+    };
+
+    return kernels[(size_t)levelType][(size_t)precision];
+}
+
+template <typename SampleType>
+template <InstructionSet isa, BallisticsFilterLevelCalculationType type, GainComputerPrecision gainPrecision>
+void MyCompressorBank<SampleType>::processGroupFor(LaneGroup& group, size_t numLanes, const SampleType* const* inputs,
+                                                   SampleType* const* outputs, size_t numSamples) noexcept
+{
+    MyCpuDispatch::Target<isa>::call([&]
+    {
+        processGroup<type, gainPrecision>(group, numLanes, inputs, outputs, numSamples);
+    });
+}
+
+template <typename SampleType>
+template <BallisticsFilterLevelCalculationType type, GainComputerPrecision gainPrecision>
+void MyCompressorBank<SampleType>::processGroup(LaneGroup& group, size_t numLanes, const SampleType* const* inputs,
+                                                SampleType* const* outputs, size_t numSamples) noexcept
+{
+    constexpr auto lanes = laneGroupSize;
+    constexpr auto isMeanSquare = type != LevelCalculationType::peak;
+
+    // Interleaved scratch as in MyCompressor: sample i of lane l lives at
+    // [i * lanes + l]
+    alignas (64) std::array<SampleType, kernelBlockSize * lanes> frames;
+
+    // Local copies, which the compiler can keep in registers: the stores to
+    // frames cannot alias them
+    const auto cteAT = group.cteAT, cteRL = group.cteRL, levelThreshold = group.levelThreshold;
+    auto state = group.state;
+
+    alignas (64) typename LaneGroup::Lanes minimumGain;
+    minimumGain.fill(static_cast<SampleType> (1.0));
+
+    for (size_t start = 0; start < numSamples; start += kernelBlockSize)
+    {
+        const auto numFrames = juce::jmin(kernelBlockSize, numSamples - start);
+
+        for (size_t lane = 0; lane < numLanes; ++lane)
+            for (size_t i = 0; i < numFrames; ++i)
+                frames[i * lanes + lane] = inputs[lane][start + i];
+
+        // The gain pass of the previous chunk left gains in the unused lanes,
+        // which must be silent again so that their detectors stay below the
+        // threshold
+        if (numLanes < lanes)
+            for (size_t i = 0; i < numFrames; ++i)
+                std::fill_n(frames.data() + i * lanes + numLanes, lanes - numLanes, static_cast<SampleType> (0.0));
+
+        // Detector pass, every lane with its own attack and release, and a
+        // count of the lanes above their threshold
+        int numAbove = 0;
+
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            auto* frame = frames.data() + i * lanes;
+
+            for (size_t lane = 0; lane < lanes; ++lane)
+            {
+                const auto x = isMeanSquare ? frame[lane] * frame[lane] : std::abs(frame[lane]);
+                const auto cte = x > state[lane] ? cteAT[lane] : cteRL[lane];
+
+                state[lane] = x + cte * (state[lane] - x);
+                frame[lane] = state[lane];
+                numAbove += state[lane] > levelThreshold[lane] ? 1 : 0;
+            }
+        }
+
+        for (auto& value : state)
+            juce::dsp::util::snapToZero(value);
+
+        // Below the threshold in every lane the gain is exactly 1
+        if (numAbove == 0)
+        {
+            for (size_t lane = 0; lane < numLanes; ++lane)
+                if (inputs[lane] != outputs[lane])
+                    std::copy(inputs[lane] + start, inputs[lane] + start + numFrames, outputs[lane] + start);
+
+            continue;
+        }
+
+        // Gain pass, overwriting the envelope with the gain to apply
+        if constexpr (gainPrecision == GainComputerPrecision::fast)
+        {
+            // A mean square needs twice the threshold and half the slope,
+            // see MyCompressor::computeGain()
+            constexpr auto scale = static_cast<SampleType> (isMeanSquare ? 2.0 : 1.0);
+            alignas (64) typename LaneGroup::Lanes log2Threshold, slope;
+
+            for (size_t lane = 0; lane < lanes; ++lane)
+            {
+                log2Threshold[lane] = group.log2Threshold[lane] * scale;
+                slope[lane] = group.slope[lane] / scale;
+            }
+
+            for (size_t i = 0; i < numFrames; ++i)
+            {
+                auto* frame = frames.data() + i * lanes;
+
+                for (size_t lane = 0; lane < lanes; ++lane)
+                {
+                    const auto overshoot = MyFastMath<SampleType>::positivePart(MyFastMath<SampleType>::log2(frame[lane]) - log2Threshold[lane]);
+                    frame[lane] = MyFastMath<SampleType>::exp2(overshoot * slope[lane]);
+                }
+            }
+        }
+        else
+        {
+            const auto thresholddB = group.thresholddB, ratioInverse = group.ratioInverse;
+
+            for (size_t i = 0; i < numFrames; ++i)
+            {
+                auto* frame = frames.data() + i * lanes;
+
+                for (size_t lane = 0; lane < lanes; ++lane)
+                {
+                    const auto level = isMeanSquare ? std::sqrt(frame[lane]) : frame[lane];
+                    const auto env = juce::Decibels::gainToDecibels(level, minus_inf);
+                    const auto y = env < thresholddB[lane] ? env : thresholddB[lane] + (env - thresholddB[lane]) * ratioInverse[lane];
+
+                    frame[lane] = juce::Decibels::decibelsToGain(y - env, minus_inf);
+                }
+            }
+        }
+
+        for (size_t i = 0; i < numFrames; ++i)
+            for (size_t lane = 0; lane < lanes; ++lane)
+                minimumGain[lane] = juce::jmin(minimumGain[lane], frames[i * lanes + lane]);
+
+        // VCA
+        for (size_t lane = 0; lane < numLanes; ++lane)
+        {
+            const auto* input = inputs[lane] + start;
+            auto* output = outputs[lane] + start;
+
+            for (size_t i = 0; i < numFrames; ++i)
+                output[i] = input[i] * frames[i * lanes + lane];
+        }
+    }
+
+    group.state = state;
+    group.minimumGain = minimumGain;
+}
+
+//==============================================================================
+template class MyCompressorBank<float>;
+template class MyCompressorBank<double>;
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MyCompressor.h"
+
+/**
+    A bank of independent mono compressors, each channel with its own
+    threshold, ratio, attack, release and RC mode.
+
+    Running many channels through separate MyCompressor objects spreads their
+    state over the heap and runs the detector of each channel on its own.
+    Here the channels are packed into groups of laneGroupSize lanes, and each
+    group keeps the coefficients and the envelope of its lanes in contiguous
+    aligned arrays (structure of arrays). The kernels run the detector and the
+    gain computer of all lanes of a group side by side in loops of a fixed
+    width, which the compiler turns into 4, 8 or 16 lanes per instruction
+    depending on the instruction set. The kernels are compiled for every
+    instruction set MyCpuDispatch knows, and prepare() picks one.
+
+    The level calculation type and the gain computer precision are shared by
+    the whole bank, so that the kernels can be specialised for them like those
+    of MyCompressor. The lookahead, the key filter, the windowed RMS detector
+    and the control rate mode are not available: use MyCompressor for those.
+
+    A channel's coefficients can be changed at any time from the audio thread
+    with setChannelCoefficients(), which writes that channel's lanes only.
+    Compute them with MyCompressorCoefficients::calculate() away from the
+    audio thread.
+
+    @tags{DSP}
+*/
+template <typename SampleType>
+class MyCompressorBank
+{
+public:
+    //==============================================================================
+    using LevelCalculationType = BallisticsFilterLevelCalculationType;
+
+    /** The number of channels processed side by side: one AVX-512 register
+        of floats, or four SSE registers.
+    */
+    static constexpr size_t laneGroupSize = 16;
+
+    /** Number of samples per channel the kernel works on at a time. */
+    static constexpr size_t kernelBlockSize = 64;
+
+    //==============================================================================
+    /** Allocates the lane groups for spec.numChannels channels and resets them.
+        All channels start with the default MyCompressorCoefficients, a ratio
+        of 1. Picks the instruction set of the kernels.
+    */
+    void prepare(const juce::dsp::ProcessSpec& spec);
+
+    /** Returns the instruction set picked by the last call to prepare(). */
+    InstructionSet getInstructionSet() const noexcept { return instructionSet; }
+
+    /** Clears the envelopes. */
+    void reset() noexcept;
+
+    /** Returns the number of channels given to prepare(). */
+    int getNumChannels() const noexcept { return (int)numChannels; }
+
+    //==============================================================================
+    /** Sets the coefficients of one channel. The lookahead, key filter and
+        control rate settings in them are ignored, as is the RMS window.
+        Like MyCompressor::setCoefficients() this can be called on the audio
+        thread, between two calls to process().
+    */
+    void setChannelCoefficients(int channel, const MyCompressorCoefficients& newCoefficients) noexcept;
+
+    /** Sets the same coefficients on every channel. */
+    void setCoefficients(const MyCompressorCoefficients& newCoefficients) noexcept;
+
+    /** Sets the level calculation type of every channel, peak or RMS. Changing
+        the type resets the envelopes.
+    */
+    void setLevelCalculationType(LevelCalculationType newType) noexcept;
+
+    /** Sets the precision of the gain computer of every channel. */
+    void setPrecision(GainComputerPrecision newPrecision) noexcept;
+
+    //==============================================================================
+    /** Processes the input and output samples supplied in the processing
+        context, which must have as many channels as given to prepare(). The
+        input and output may be the same buffer.
+    */
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert(inputBlock.getNumChannels() == numChannels);
+        jassert(outputBlock.getNumChannels() == numChannels);
+        jassert(inputBlock.getNumSamples() == numSamples);
+
+        if (context.isBypassed)
+        {
+            if (inputBlock.getChannelPointer(0) != outputBlock.getChannelPointer(0))
+                outputBlock.copyFrom(inputBlock);
+
+            return;
+        }
+
+        const auto kernel = getKernel();
+
+        for (size_t group = 0; group < groups.size(); ++group)
+        {
+            const auto firstChannel = group * laneGroupSize;
+            const auto numLanes = juce::jmin(laneGroupSize, numChannels - firstChannel);
+
+            std::array<const SampleType*, laneGroupSize> inputs{};
+            std::array<SampleType*, laneGroupSize> outputs{};
+
+            for (size_t lane = 0; lane < numLanes; ++lane)
+            {
+                inputs[lane] = inputBlock.getChannelPointer(firstChannel + lane);
+                outputs[lane] = outputBlock.getChannelPointer(firstChannel + lane);
+            }
+
+            (this->*kernel)(groups[group], numLanes, inputs.data(), outputs.data(), numSamples);
+        }
+    }
+
+    /** Returns the smallest gain a channel applied during the last call to
+        process(), for a gain reduction meter.
+    */
+    SampleType getMinimumGain(int channel) const noexcept;
+
+private:
+    //==============================================================================
+    /** The coefficients and state of laneGroupSize channels, one array per
+        quantity. Unused lanes of the last group have a ratio of 1 and a
+        silent input, so their gain stays 1.
+    */
+    struct alignas (64) LaneGroup
+    {
+        using Lanes = std::array<SampleType, laneGroupSize>;
+
+        Lanes cteAT, cteRL, state;
+        Lanes thresholddB, ratioInverse, log2Threshold, slope;
+
+        /** The threshold as the detector measures it: a gain for the peak
+            detector, a mean square for the RMS detector.
+        */
+        Lanes levelThreshold;
+
+        Lanes minimumGain;
+    };
+
+    using Kernel = void (MyCompressorBank::*)(LaneGroup&, size_t, const SampleType* const*, SampleType* const*, size_t) noexcept;
+
+    template <LevelCalculationType levelType, GainComputerPrecision gainPrecision>
+    void processGroup(LaneGroup& group, size_t numLanes, const SampleType* const* inputs,
+                      SampleType* const* outputs, size_t numSamples) noexcept;
+
+    /** processGroup(), inlined into code compiled for an instruction set. */
+    template <InstructionSet isa, LevelCalculationType levelType, GainComputerPrecision gainPrecision>
+    void processGroupFor(LaneGroup& group, size_t numLanes, const SampleType* const* inputs,
+                         SampleType* const* outputs, size_t numSamples) noexcept;
+
+    /** Looks up the kernel for the current settings, once per block. */
+    Kernel getKernel() const noexcept;
+
+    template <InstructionSet isa>
+    Kernel getKernelFor() const noexcept;
+
+    /** Writes the coefficients of one lane of a group. */
+    void setLaneCoefficients(LaneGroup& group, size_t lane, const MyCompressorCoefficients& newCoefficients) noexcept;
+
+    //==============================================================================
+    std::vector<LaneGroup> groups;
+    size_t numChannels = 0;
+
+    LevelCalculationType levelType = LevelCalculationType::peak;
+    GainComputerPrecision precision = GainComputerPrecision::exact;
+    InstructionSet instructionSet = InstructionSet::generic;
+
+    SampleType minus_inf = static_cast<SampleType> (-200.0);
+};
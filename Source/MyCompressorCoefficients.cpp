@@ -0,0 +1,146 @@
+#include <JuceHeader.h>
+#include "MyCompressorCoefficients.h"
+#include "MyEnvelopeDetector.h"
+
+MyCompressorCoefficients MyCompressorCoefficients::calculate(const MyCompressorParameters& parameters, double sampleRate) noexcept
+{
+    jassert(parameters.ratio >= 1.0);
+    jassert(sampleRate > 0);
+
+    MyCompressorCoefficients c;
+    c.parameters = parameters;
+
+    c.cteAT = MyEnvelopeDetector<double>::calculateLimitedCte(parameters.attackTime, parameters.rcMode, sampleRate);
+    c.cteRL = MyEnvelopeDetector<double>::calculateLimitedCte(parameters.releaseTime, parameters.rcMode, sampleRate);
+
+    c.threshold = juce::Decibels::decibelsToGain(parameters.thresholddB, -200.0);
+    c.thresholdInverse = 1.0 / c.threshold;
+    c.ratioInverse = 1.0 / parameters.ratio;
+
+    // 20 * log10 (2) dB per octave
+    c.log2Threshold = parameters.thresholddB / 6.020599913279624;
+    c.slope = c.ratioInverse - 1.0;
+
+    const auto lookaheadTime = juce::jlimit(0.0, MyCompressorParameters::maximumLookaheadTime, parameters.lookaheadTime);
+    c.lookaheadSamples = juce::roundToInt(lookaheadTime * 0.001 * sampleRate);
+
+    const auto rmsWindowTime = juce::jlimit(0.0, MyEnvelopeDetector<double>::maximumRMSWindowTime, parameters.rmsWindowTime);
+    c.rmsWindowSamples = juce::jmax(1, juce::roundToInt(rmsWindowTime * 0.001 * sampleRate));
+
+    if (parameters.controlRate)
+    {
+        const auto limit = juce::jmin((double)maximumControlRateFactor, sampleRate / 48000.0,
+                                      parameters.attackTime * 0.001 * sampleRate / 8.0);
+
+        while (c.controlRateFactor * 2 <= limit)
+            c.controlRateFactor *= 2;
+    }
+
+    const auto controlSampleRate = sampleRate / c.controlRateFactor;
+    c.controlCteAT = MyEnvelopeDetector<double>::calculateLimitedCte(parameters.attackTime, parameters.rcMode, controlSampleRate);
+    c.controlCteRL = MyEnvelopeDetector<double>::calculateLimitedCte(parameters.releaseTime, parameters.rcMode, controlSampleRate);
+    c.controlRMSWindowSamples = juce::jmax(1, juce::roundToInt((double)c.rmsWindowSamples / c.controlRateFactor));
+
+    // RBJ cookbook high-pass and band-pass (constant 0 dB peak gain)
+    if (parameters.sidechainFilterType != SidechainFilterType::off)
+    {
+        const auto frequency = juce::jlimit(10.0, sampleRate * 0.49, parameters.sidechainFilterFrequency);
+        const auto w0 = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+        const auto cosW0 = std::cos(w0);
+        const auto alpha = std::sin(w0) / (2.0 * juce::jmax(0.1, parameters.sidechainFilterQ));
+        const auto a0Inverse = 1.0 / (1.0 + alpha);
+
+        if (parameters.sidechainFilterType == SidechainFilterType::highPass)
+            c.sidechainFilter = { (1.0 + cosW0) * 0.5, -(1.0 + cosW0), (1.0 + cosW0) * 0.5, -2.0 * cosW0, 1.0 - alpha };
+        else
+            c.sidechainFilter = { alpha, 0.0, -alpha, -2.0 * cosW0, 1.0 - alpha };
+
+        for (auto& coefficient : c.sidechainFilter)
+            coefficient *= a0Inverse;
+    }
+
+    return c;
+}
+
+int MyCompressorCoefficients::calculateWarmUpSamples(BallisticsFilterLevelCalculationType levelType, double keyPeak,
+                                                     double maximumErrordB) const noexcept
+{
+    jassert(maximumErrordB > 0.0);
+
+    const auto isMeanSquare = levelType != BallisticsFilterLevelCalculationType::peak;
+    const auto isDecimated = controlRateFactor > 1;
+    const auto attack = isDecimated ? controlCteAT : cteAT;
+    const auto release = isDecimated ? controlCteRL : cteRL;
+    const auto contraction = juce::jmax(attack, release);
+
+    // Samples for an error that shrinks by contraction per sample to fall
+    // from initialError to tolerance
+    const auto getDecaySamples = [](double contraction, double initialError, double tolerance)
+    {
+        if (initialError <= tolerance || contraction <= 0.0)
+            return 0.0;
+
+        return std::ceil(std::log(tolerance / initialError) / std::log(contraction));
+    };
+
+    auto total = (double)lookaheadSamples;
+
+    // At a ratio of 1 the gain is 1 whatever the envelope, and a holding
+    // envelope never leaves the reset state, warm or not
+    const auto curveSlope = 1.0 - ratioInverse;
+
+    if (curveSlope > 0.0 && contraction >= 1.0 && juce::jmin(attack, release) < 1.0)
+        return -1;
+
+    if (curveSlope > 0.0 && contraction < 1.0)
+    {
+        // The largest error in the key level that keeps the gain within
+        // maximumErrordB, half of it left to the key filter and half to the
+        // detector
+        const auto levelError = std::pow(10.0, maximumErrordB / curveSlope / 20.0) - 1.0;
+        const auto tolerance = 0.5 * levelError * threshold;
+
+        if (parameters.sidechainFilterType != SidechainFilterType::off)
+        {
+            // The key filter forgets its state with its pole radius, and can
+            // raise the key by the sum of its impulse response at most
+            const auto [b0, b1, b2, a1, a2] = sidechainFilter;
+            const auto discriminant = a1 * a1 - 4.0 * a2;
+            const auto poleRadius = discriminant < 0.0 ? std::sqrt(a2)
+                                                       : (std::abs(a1) + std::sqrt(discriminant)) * 0.5;
+
+            auto gain = 0.0, x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+
+            for (int i = 0; i < 1 << 20; ++i)
+            {
+                const auto x = i == 0 ? 1.0 : 0.0;
+                const auto y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+
+                gain += std::abs(y);
+                x2 = x1; x1 = x;
+                y2 = y1; y1 = y;
+
+                if (i > 2 && std::abs(y1) + std::abs(y2) < 1.0e-12 * gain)
+                    break;
+            }
+
+            keyPeak *= juce::jmax(1.0, gain);
+            total += getDecaySamples(poleRadius, keyPeak, tolerance);
+        }
+
+        if (levelType == BallisticsFilterLevelCalculationType::windowedRMS)
+            total += rmsWindowSamples;
+
+        // A mean square envelope is compared in power, (threshold + tolerance)^2
+        // - threshold^2. At the control rate the decay is counted in control
+        // periods, plus the two periods the interpolated gain trails the detector.
+        const auto factor = (double)controlRateFactor;
+        const auto detectorSamples = isMeanSquare ? getDecaySamples(contraction, keyPeak * keyPeak, tolerance * (2.0 * threshold + tolerance))
+                                                  : getDecaySamples(contraction, keyPeak, tolerance);
+
+        total += detectorSamples * factor + (isDecimated ? 2.0 * factor : 0.0);
+    }
+
+    const auto multiple = (double)maximumControlRateFactor;
+    return (int)juce::jmin(std::ceil(total / multiple) * multiple, (double)(std::numeric_limits<int>::max() / 2));
+}
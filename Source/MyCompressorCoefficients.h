@@ -0,0 +1,102 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MyEnvelopeDetector.h"
+
+/** The filter applied to the detector's key signal, see MySidechainFilter. */
+enum class SidechainFilterType
+{
+    off,
+    highPass,
+    bandPass
+};
+
+/** The user facing settings of MyCompressor. */
+struct MyCompressorParameters
+{
+    /** The longest lookahead in ms that MyCompressor::prepare() allocates for. */
+    static constexpr double maximumLookaheadTime = 20.0;
+
+    double thresholddB = 0.0, ratio = 1.0, attackTime = 1.0, releaseTime = 100.0;
+    double lookaheadTime = 0.0, rmsWindowTime = 300.0;
+    int rcMode = 0;
+
+    SidechainFilterType sidechainFilterType = SidechainFilterType::off;
+    double sidechainFilterFrequency = 100.0, sidechainFilterQ = 0.7071;
+
+    /** Runs the detector and the gain computer at a reduced control rate
+        where the sample rate allows it, see MyCompressorCoefficients::controlRateFactor.
+    */
+    bool controlRate = false;
+};
+
+/**
+    A complete set of precomputed coefficients for MyCompressor.
+
+    Computing the coefficients needs std::exp and std::pow, so this is done once
+    per parameter change, away from the audio thread, and the result is handed
+    to MyCompressor::setCoefficients(). The values are kept in double precision
+    so that one snapshot can be shared by the float and the double engines.
+
+    @tags{DSP}
+*/
+struct MyCompressorCoefficients
+{
+    /** Computes the coefficients for a set of parameters at a given sample rate. */
+    static MyCompressorCoefficients calculate(const MyCompressorParameters& parameters, double sampleRate) noexcept;
+
+    /** Returns how many samples a compressor has to process after reset()
+        before its gain agrees with that of a compressor which has been
+        running all along to within maximumErrordB, for a detector key that
+        never exceeds keyPeak (linear, after the channel link).
+
+        The detector is a contraction: two envelopes fed the same key move
+        apart by at most the larger of the attack and release coefficients
+        per sample, and neither leaves the range of the key. An envelope
+        started from silence therefore lies within keyPeak * cte ^ n of the
+        running one after n samples. An envelope error only reaches the gain
+        above the threshold, scaled by the slope 1 - 1 / ratio of the static
+        curve, so n follows from the threshold, the ratio and maximumErrordB.
+        The lookahead delay, the RMS window and the decay of the key filter
+        are added on top. The result is a multiple of maximumControlRateFactor,
+        so that a warm-up started on such a multiple keeps the control periods
+        of the control rate mode in step.
+
+        Returns -1 if the envelope never forgets its past, as with a level RC
+        detector that has an instantaneous attack and so holds its peak.
+    */
+    int calculateWarmUpSamples(BallisticsFilterLevelCalculationType levelType, double keyPeak, double maximumErrordB) const noexcept;
+
+    MyCompressorParameters parameters;
+
+    double cteAT = 0.0, cteRL = 0.0;
+    double threshold = 1.0, thresholdInverse = 1.0, ratioInverse = 1.0, log2Threshold = 0.0, slope = 0.0;
+
+    /** The lookahead delay, which is also the latency of the compressor. */
+    int lookaheadSamples = 0;
+
+    /** The window length of the windowed RMS detector. */
+    int rmsWindowSamples = 1;
+
+    /** The sidechain biquad, normalised so that a0 = 1: b0, b1, b2, a1, a2. */
+    std::array<double, 5> sidechainFilter{ 1.0, 0.0, 0.0, 0.0, 0.0 };
+
+    /** The longest decimation of the control rate mode. It divides the block
+        size of the MyCompressor kernel.
+    */
+    static constexpr int maximumControlRateFactor = 16;
+
+    /** The number of samples per control period, 1 when the control rate mode
+        is off or gains nothing.
+
+        This is the largest power of two up to maximumControlRateFactor that
+        keeps the control rate at or above 48 kHz and gives at least 8 control
+        periods per attack time, so the envelope moves by less than an eighth
+        of its attack time constant between two interpolated gains.
+    */
+    int controlRateFactor = 1;
+
+    /** The detector coefficients and RMS window at the control rate. */
+    double controlCteAT = 0.0, controlCteRL = 0.0;
+    int controlRMSWindowSamples = 1;
+};
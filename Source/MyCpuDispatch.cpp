@@ -0,0 +1,84 @@
+#include <JuceHeader.h>
+#include "MyCpuDispatch.h"
+
+namespace
+{
+    // -1 when there is no override
+    std::atomic<int> instructionSetOverride{ -1 };
+}
+
+//==============================================================================
+InstructionSet MyCpuDispatch::getInstructionSet() noexcept
+{
+    const auto overrideValue = instructionSetOverride.load();
+
+    if (overrideValue >= 0 && isSupported(static_cast<InstructionSet>(overrideValue)))
+        return static_cast<InstructionSet>(overrideValue);
+
+    return detectInstructionSet();
+}
+
+InstructionSet MyCpuDispatch::detectInstructionSet() noexcept
+{
+    // The CPU does not change while the process runs. AVX-512 is left out on
+    // purpose, see the class description.
+    static const auto best = isSupported(InstructionSet::avx2) ? InstructionSet::avx2
+                                                               : InstructionSet::generic;
+    return best;
+}
+
+bool MyCpuDispatch::isSupported(InstructionSet instructionSet) noexcept
+{
+#if MY_CPU_DISPATCH
+    switch (instructionSet)
+    {
+        case InstructionSet::avx2:
+            return juce::SystemStats::hasAVX2();
+
+        case InstructionSet::avx512:
+            return juce::SystemStats::hasAVX2() && juce::SystemStats::hasAVX512F() && juce::SystemStats::hasAVX512BW()
+                && juce::SystemStats::hasAVX512DQ() && juce::SystemStats::hasAVX512VL();
+
+        case InstructionSet::generic:
+        default:
+            return true;
+    }
+#else
+    return instructionSet == InstructionSet::generic;
+#endif
+}
+
+void MyCpuDispatch::setOverride(InstructionSet instructionSet) noexcept
+{
+    instructionSetOverride = static_cast<int>(instructionSet);
+}
+
+void MyCpuDispatch::clearOverride() noexcept
+{
+    instructionSetOverride = -1;
+}
+
+const char* MyCpuDispatch::getName(InstructionSet instructionSet) noexcept
+{
+    switch (instructionSet)
+    {
+        case InstructionSet::avx2:      return "avx2";
+        case InstructionSet::avx512:    return "avx512";
+        case InstructionSet::generic:
+        default:                        return "generic";
+    }
+}
+
+bool MyCpuDispatch::fromName(const juce::String& name, InstructionSet& instructionSet) noexcept
+{
+    for (auto candidate : { InstructionSet::generic, InstructionSet::avx2, InstructionSet::avx512 })
+    {
+        if (name.equalsIgnoreCase(getName(candidate)))
+        {
+            instructionSet = candidate;
+            return true;
+        }
+    }
+
+    return false;
+}
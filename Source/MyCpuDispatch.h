@@ -0,0 +1,147 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/** The instruction sets the kernels are compiled for. generic is whatever the
+    build targets, SSE2 for a plain x86-64 build.
+*/
+enum class InstructionSet
+{
+    generic,
+    avx2,
+    avx512
+};
+
+// The extra instruction sets need per-function target attributes, which GCC
+// and Clang have on x86-64. Other builds only have the generic kernels.
+#if (JUCE_GCC || JUCE_CLANG) && JUCE_INTEL && JUCE_64BIT
+ #define MY_CPU_DISPATCH 1
+ #define MY_TARGET_AVX2   __attribute__ ((target ("avx2"), flatten))
+ #define MY_TARGET_AVX512 __attribute__ ((target ("avx2,avx512f,avx512bw,avx512dq,avx512vl"), flatten))
+#else
+ #define MY_CPU_DISPATCH 0
+#endif
+
+/**
+    Picks the instruction set of the DSP kernels at run time, so that one
+    binary runs the fastest kernels a machine supports.
+
+    MyCompressor, MyCompressorBank, MyEnvelopeDetector, MySidechainFilter and
+    MyLookahead compile their block kernels once per InstructionSet, each in
+    its own translation unit, and ask getInstructionSet() which ones to use in
+    prepare(). A kernel only gets the wider instructions for the code the
+    compiler can see, so a stage called from another class's kernel
+    dispatches by itself rather than relying on flatten to inline it.
+
+    The variants are the same source, compiled in translation units that do
+    not contract multiplies and adds into fused multiply-adds (only some of
+    the instruction sets have them), and with no reductions whose order
+    depends on the vector width. Every variant therefore rounds every
+    operation the same way, which CompressorBenchmark --verify checks by
+    running every supported instruction set on the same input.
+
+    The AVX-512 kernels are not picked automatically: the detector and
+    ballistics recurrences are serial per channel, and in CompressorBenchmark
+    they ran no faster than the AVX2 ones, and often slower. They are used
+    when setOverride() asks for them.
+
+    @tags{DSP}
+*/
+struct MyCpuDispatch
+{
+    /** Returns the instruction set the kernels should use: the override if
+        one is set and supported, otherwise detectInstructionSet().
+    */
+    static InstructionSet getInstructionSet() noexcept;
+
+    /** Returns the fastest instruction set the CPU has, from CPUID: AVX2 if
+        it has it, otherwise generic.
+    */
+    static InstructionSet detectInstructionSet() noexcept;
+
+    /** Returns true if the CPU runs the kernels of an instruction set and
+        this build contains them.
+    */
+    static bool isSupported(InstructionSet instructionSet) noexcept;
+
+    /** Makes getInstructionSet() return an instruction set other than the
+        detected one, for testing, for comparing the variants and for AVX-512.
+        An unsupported one falls back to the detected one. Takes effect in the
+        next prepare().
+    */
+    static void setOverride(InstructionSet instructionSet) noexcept;
+
+    /** Removes the override. */
+    static void clearOverride() noexcept;
+
+    /** Returns "generic", "avx2" or "avx512". */
+    static const char* getName(InstructionSet instructionSet) noexcept;
+
+    /** Parses a name returned by getName(). Returns false for any other text. */
+    static bool fromName(const juce::String& name, InstructionSet& instructionSet) noexcept;
+
+    //==============================================================================
+    /** Calls a function in code compiled for an instruction set. Everything
+        the function calls that the compiler can see is inlined into that code
+        (the flatten attribute), so a kernel written as a plain function runs
+        with the wider registers throughout.
+    */
+    template <InstructionSet instructionSet>
+    struct Target
+    {
+        template <typename Function>
+        static forcedinline void call(Function&& function) noexcept { function(); }
+    };
+
+    /** Calls a function in code compiled for an instruction set picked at run
+        time, for the stages that have a single kernel rather than a table of
+        them.
+    */
+    template <typename Function>
+    static void call(InstructionSet instructionSet, Function&& function) noexcept;
+};
+
+#if MY_CPU_DISPATCH
+// GCC decides on contraction per function, after inlining, so the kernels
+// inlined into these must not be contracted even though AVX-512 has FMA
+#if JUCE_GCC
+ #pragma GCC push_options
+ #pragma GCC optimize ("fp-contract=off")
+#endif
+
+template <>
+struct MyCpuDispatch::Target<InstructionSet::avx2>
+{
+    template <typename Function>
+    MY_TARGET_AVX2 static void call(Function&& function) noexcept { function(); }
+};
+
+template <>
+struct MyCpuDispatch::Target<InstructionSet::avx512>
+{
+    template <typename Function>
+    MY_TARGET_AVX512 static void call(Function&& function) noexcept { function(); }
+};
+
+#if JUCE_GCC
+ #pragma GCC pop_options
+#endif
+#endif
+
+template <typename Function>
+forcedinline void MyCpuDispatch::call(InstructionSet instructionSet, Function&& function) noexcept
+{
+#if MY_CPU_DISPATCH
+    switch (instructionSet)
+    {
+        case InstructionSet::avx2:      Target<InstructionSet::avx2>::call(function); return;
+        case InstructionSet::avx512:    Target<InstructionSet::avx512>::call(function); return;
+        case InstructionSet::generic:
+        default:                        break;
+    }
+#else
+    juce::ignoreUnused(instructionSet);
+#endif
+
+    function();
+}
@@ -1,12 +1,20 @@
 #include <JuceHeader.h>
 #include "MyEnvelopeDetector.h"
 
+// See MyCompressor.cpp: the kernels are compiled for several instruction sets,
+// and without contraction all of them round the same way
+#if JUCE_GCC
+ #pragma GCC optimize ("fp-contract=off")
+#elif JUCE_CLANG
+ #pragma STDC FP_CONTRACT OFF
+#endif
+
 template <typename SampleType>
 MyEnvelopeDetector<SampleType>::MyEnvelopeDetector()
 {
     setAttackTime(attackTime);
     setReleaseTime(releaseTime);
-    setTC(TC);
+    setTC(tcMode);
 }
 
 template <typename SampleType>
@@ -26,12 +34,47 @@ void MyEnvelopeDetector<SampleType>::setReleaseTime(SampleType releaseTimeMs)
 template <typename SampleType>
 void MyEnvelopeDetector<SampleType>::setLevelCalculationType(LevelCalculationType newLevelType)
 {
-    levelType = newLevelType;
-    reset();
+    if (levelType != newLevelType)
+    {
+        levelType = newLevelType;
+        reset();
+    }
+}
+
+template <typename SampleType>
+void MyEnvelopeDetector<SampleType>::setRMSWindowTime(SampleType windowTimeMs)
+{
+    jassert(windowTimeMs > static_cast<SampleType> (0.0));
+
+    rmsWindowTime = juce::jmin(windowTimeMs, static_cast<SampleType> (maximumRMSWindowTime));
+
+    // Before prepare() there is no window yet: keep the time for prepare()
+    if (rmsWindowCapacity > 0)
+        setRMSWindowLength(juce::roundToInt(rmsWindowTime * 0.001 * sampleRate));
+}
+
+template <typename SampleType>
+void MyEnvelopeDetector<SampleType>::setRMSWindowLength(int numSamples) noexcept
+{
+    // The time follows the length actually used, so that prepare() applies
+    // the same window again
+    const auto newLength = (size_t)juce::jlimit(1, juce::jmax(1, (int)rmsWindowCapacity), numSamples);
+    rmsWindowTime = static_cast<SampleType> ((double)newLength * 1000.0 / sampleRate);
+
+    if (newLength != rmsWindowLength)
+    {
+        rmsWindowLength = newLength;
+        rmsWindowLengthInverse = static_cast<SampleType> (1.0 / (double)newLength);
+        resetWindow();
+    }
 }
 
 template <typename SampleType>
 void MyEnvelopeDetector<SampleType>::setTC(int mode) {
+    jassert(juce::isPositiveAndBelow(mode, TC_MAP.size()));
+
+    tcMode = mode;
+
     if (TC != TC_MAP[mode]) {
         TC = TC_MAP[mode];
         setAttackTime(attackTime);
@@ -40,6 +83,20 @@ void MyEnvelopeDetector<SampleType>::setTC(int mode) {
     
 }
 
+template <typename SampleType>
+void MyEnvelopeDetector<SampleType>::setCoefficients(SampleType attackTimeMs, SampleType releaseTimeMs, int mode,
+                                                     SampleType attackCoefficient, SampleType releaseCoefficient) noexcept
+{
+    jassert(juce::isPositiveAndBelow(mode, TC_MAP.size()));
+
+    attackTime = attackTimeMs;
+    releaseTime = releaseTimeMs;
+    tcMode = mode;
+    TC = TC_MAP[(size_t)mode];
+    cteAT = attackCoefficient;
+    cteRL = releaseCoefficient;
+}
+
 template <typename SampleType>
 void MyEnvelopeDetector<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
 {
@@ -47,12 +104,24 @@ void MyEnvelopeDetector<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
     jassert(spec.numChannels > 0);
 
     sampleRate = spec.sampleRate;
+    instructionSet = MyCpuDispatch::getInstructionSet();
 
     setAttackTime(attackTime);
     setReleaseTime(releaseTime);
-    setTC(TC);
 
-    yold.resize(spec.numChannels);
+    // The state is padded to a whole number of vector registers so that the
+    // block kernels can always load and store full lanes.
+    const auto numLanes = SIMDType::size();
+    yold.resize(((spec.numChannels + numLanes - 1) / numLanes) * numLanes);
+
+    // One extra register of storage so the window can start on a SIMD boundary
+    rmsWindowCapacity = (size_t)juce::jmax(1, juce::roundToInt(maximumRMSWindowTime * 0.001 * sampleRate));
+    rmsWindowStorage.assign(yold.size() * rmsWindowCapacity + numLanes, static_cast<SampleType> (0.0));
+    rmsWindow = SIMDType::getNextSIMDAlignedPtr(rmsWindowStorage.data());
+    rmsSums.resize(yold.size());
+    rmsPositions.resize(yold.size());
+
+    setRMSWindowTime(rmsWindowTime);
 
     reset();
 }
@@ -68,6 +137,16 @@ void MyEnvelopeDetector<SampleType>::reset(SampleType initialValue)
 {
     for (auto& old : yold)
         old = initialValue;
+
+    resetWindow();
+}
+
+template <typename SampleType>
+void MyEnvelopeDetector<SampleType>::resetWindow() noexcept
+{
+    std::fill(rmsWindowStorage.begin(), rmsWindowStorage.end(), static_cast<SampleType> (0.0));
+    std::fill(rmsSums.begin(), rmsSums.end(), static_cast<SampleType> (0.0));
+    std::fill(rmsPositions.begin(), rmsPositions.end(), 0);
 }
 
 template <typename SampleType>
@@ -77,6 +156,8 @@ SampleType MyEnvelopeDetector<SampleType>::processSample(int channel, SampleType
 
     if (levelType == LevelCalculationType::RMS)
         inputValue *= inputValue;
+    else if (levelType == LevelCalculationType::windowedRMS)
+        inputValue = processWindowSample((size_t)channel, inputValue * inputValue);
     else
         inputValue = std::abs(inputValue);
 
@@ -85,12 +166,231 @@ SampleType MyEnvelopeDetector<SampleType>::processSample(int channel, SampleType
     SampleType result = inputValue + cte * (yold[(size_t)channel] - inputValue);
     yold[(size_t)channel] = result;
 
-    if (levelType == LevelCalculationType::RMS)
+    if (levelType != LevelCalculationType::peak)
         return std::sqrt(result);
 
     return result;
 }
 
+template <typename SampleType>
+void MyEnvelopeDetector<SampleType>::processEnvelope(size_t channel, const SampleType* input,
+                                                     SampleType* envelope, size_t numSamples) noexcept
+{
+    jassert(channel < yold.size());
+    (this->*getKernels().envelope)(channel, input, envelope, numSamples);
+}
+
+template <typename SampleType>
+void MyEnvelopeDetector<SampleType>::processEnvelopeLanes(size_t firstChannel, const SampleType* frames,
+                                                          SampleType* envelope, size_t numFrames) noexcept
+{
+    jassert(firstChannel % SIMDType::size() == 0);
+    (this->*getKernels().envelopeLanes)(firstChannel, frames, envelope, numFrames);
+}
+
+template <typename SampleType>
+typename MyEnvelopeDetector<SampleType>::Kernels MyEnvelopeDetector<SampleType>::getKernels() const noexcept
+{
+#if MY_CPU_DISPATCH
+    switch (instructionSet)
+    {
+        case InstructionSet::avx2:      return getKernelsFor<InstructionSet::avx2>();
+        case InstructionSet::avx512:    return getKernelsFor<InstructionSet::avx512>();
+        case InstructionSet::generic:
+        default:                        break;
+    }
+#endif
+
+    return getKernelsFor<InstructionSet::generic>();
+}
+
+template <typename SampleType>
+template <InstructionSet isa>
+typename MyEnvelopeDetector<SampleType>::Kernels MyEnvelopeDetector<SampleType>::getKernelsFor() const noexcept
+{
+    using Type = LevelCalculationType;
+
+    // Indexed by level calculation type, then by holding
+    static constexpr Kernels kernels[3][2] = {
+        { makeKernels<isa, Type::peak, false>(), makeKernels<isa, Type::peak, true>() },
+        { makeKernels<isa, Type::RMS, false>(), makeKernels<isa, Type::RMS, true>() },
+        { makeKernels<isa, Type::windowedRMS, false>(), makeKernels<isa, Type::windowedRMS, true>() }
+    };
+
+    return kernels[(size_t)levelType][isHolding() ? 1 : 0];
+}
+
+template <typename SampleType>
+template <InstructionSet isa, BallisticsFilterLevelCalculationType type, bool holding>
+void MyEnvelopeDetector<SampleType>::processEnvelopeFor(size_t channel, const SampleType* input,
+                                                        SampleType* envelope, size_t numSamples) noexcept
+{
+    MyCpuDispatch::Target<isa>::call([&] { processEnvelopeKernel<type, holding>(channel, input, envelope, numSamples); });
+}
+
+template <typename SampleType>
+template <InstructionSet isa, BallisticsFilterLevelCalculationType type, bool holding>
+void MyEnvelopeDetector<SampleType>::processEnvelopeLanesFor(size_t firstChannel, const SampleType* frames,
+                                                             SampleType* envelope, size_t numFrames) noexcept
+{
+    MyCpuDispatch::Target<isa>::call([&] { processEnvelopeLanesKernel<type, holding>(firstChannel, frames, envelope, numFrames); });
+}
+
+template <typename SampleType>
+template <BallisticsFilterLevelCalculationType type, bool holding>
+void MyEnvelopeDetector<SampleType>::processEnvelopeKernel(size_t channel, const SampleType* input,
+                                                           SampleType* envelope, size_t numSamples) noexcept
+{
+    auto state = yold[channel];
+    const auto attack = cteAT, release = cteRL;
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        // The window must see every sample even while the envelope holds
+        if constexpr (type == LevelCalculationType::windowedRMS)
+        {
+            const auto level = processWindowSample(channel, input[i] * input[i]);
+
+            if constexpr (! holding)
+                state = level + (level > state ? attack : release) * (state - level);
+        }
+        else if constexpr (! holding)
+        {
+            const auto level = type == LevelCalculationType::RMS ? input[i] * input[i] : std::abs(input[i]);
+            state = level + (level > state ? attack : release) * (state - level);
+        }
+
+        envelope[i] = state;
+    }
+
+    yold[channel] = state;
+}
+
+template <typename SampleType>
+template <BallisticsFilterLevelCalculationType type, bool holding>
+void MyEnvelopeDetector<SampleType>::processEnvelopeLanesKernel(size_t firstChannel, const SampleType* frames,
+                                                                SampleType* envelope, size_t numFrames) noexcept
+{
+    constexpr auto lanes = SIMDType::size();
+    const auto* level = frames;
+
+    // The windowed mean square is written to the envelope buffer and
+    // filtered in place
+    if constexpr (type == LevelCalculationType::windowedRMS)
+    {
+        processWindowLanes(firstChannel, frames, envelope, numFrames);
+        level = envelope;
+    }
+
+    auto state = loadState(firstChannel);
+
+    if constexpr (holding)
+    {
+        juce::ignoreUnused(level);
+
+        for (size_t i = 0; i < numFrames * lanes; i += lanes)
+            state.copyToRawArray(envelope + i);
+    }
+    else
+    {
+        const auto attack = SIMDType::expand(cteAT);
+        const auto release = SIMDType::expand(cteRL);
+
+        for (size_t i = 0; i < numFrames * lanes; i += lanes)
+        {
+            auto x = SIMDType::fromRawArray(level + i);
+
+            if constexpr (type == LevelCalculationType::RMS)
+                x = x * x;
+            else if constexpr (type == LevelCalculationType::peak)
+                x = SIMDType::abs(x);
+
+            const auto isAttack = SIMDType::greaterThan(x, state);
+            state = x + ((attack & isAttack) + (release & ~isAttack)) * (state - x);
+            state.copyToRawArray(envelope + i);
+        }
+    }
+
+    storeState(firstChannel, state);
+}
+
+template <typename SampleType>
+SampleType MyEnvelopeDetector<SampleType>::processWindowSample(size_t channel, SampleType square) noexcept
+{
+    constexpr auto lanes = SIMDType::size();
+
+    // The same layout as processWindowLanes(): sample p of lane l of a group
+    // lives at [p * lanes + l]
+    auto* window = rmsWindow + (channel / lanes) * rmsWindowCapacity * lanes + channel % lanes;
+    auto& position = rmsPositions[channel];
+    auto& sum = rmsSums[channel];
+
+    sum += square - window[position * lanes];
+    window[position * lanes] = square;
+
+    if (++position == rmsWindowLength)
+    {
+        position = 0;
+        sum = 0;
+
+        for (size_t i = 0; i < rmsWindowLength; ++i)
+            sum += window[i * lanes];
+    }
+
+    return juce::jmax(sum, static_cast<SampleType> (0.0)) * rmsWindowLengthInverse;
+}
+
+template <typename SampleType>
+void MyEnvelopeDetector<SampleType>::processWindowLanes(size_t firstChannel, const SampleType* frames,
+                                                        SampleType* meanSquares, size_t numFrames) noexcept
+{
+    constexpr auto lanes = SIMDType::size();
+    jassert(firstChannel % lanes == 0 && firstChannel < yold.size());
+
+    auto* window = rmsWindow + (firstChannel / lanes) * rmsWindowCapacity * lanes;
+    auto position = rmsPositions[firstChannel];
+
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, lanes> sums;
+    std::copy_n(rmsSums.begin() + (std::ptrdiff_t)firstChannel, lanes, sums.begin());
+    auto sum = SIMDType::fromRawArray(sums.data());
+
+    const auto lengthInverse = SIMDType::expand(rmsWindowLengthInverse);
+    const auto zero = SIMDType::expand(static_cast<SampleType> (0.0));
+
+    for (size_t i = 0; i < numFrames; ++i)
+    {
+        const auto x = SIMDType::fromRawArray(frames + i * lanes);
+        const auto square = x * x;
+
+        sum += square - SIMDType::fromRawArray(window + position * lanes);
+        square.copyToRawArray(window + position * lanes);
+
+        // A running sum can round to slightly below zero after a loud passage
+        (SIMDType::max(sum, zero) * lengthInverse).copyToRawArray(meanSquares + i * lanes);
+
+        if (++position == rmsWindowLength)
+        {
+            position = 0;
+            sum = sumWindowLanes(window);
+        }
+    }
+
+    sum.copyToRawArray(sums.data());
+    std::copy(sums.begin(), sums.end(), rmsSums.begin() + (std::ptrdiff_t)firstChannel);
+    std::fill_n(rmsPositions.begin() + (std::ptrdiff_t)firstChannel, lanes, position);
+}
+
+template <typename SampleType>
+typename MyEnvelopeDetector<SampleType>::SIMDType MyEnvelopeDetector<SampleType>::sumWindowLanes(const SampleType* window) const noexcept
+{
+    auto sum = SIMDType::expand(static_cast<SampleType> (0.0));
+
+    for (size_t i = 0; i < rmsWindowLength; ++i)
+        sum += SIMDType::fromRawArray(window + i * SIMDType::size());
+
+    return sum;
+}
+
 template <typename SampleType>
 void MyEnvelopeDetector<SampleType>::snapToZero() noexcept
 {
@@ -98,6 +398,34 @@ void MyEnvelopeDetector<SampleType>::snapToZero() noexcept
         juce::dsp::util::snapToZero(old);
 }
 
+template <typename SampleType>
+typename MyEnvelopeDetector<SampleType>::SIMDType MyEnvelopeDetector<SampleType>::loadState(size_t firstChannel) const noexcept
+{
+    jassert(firstChannel + SIMDType::size() <= yold.size());
+
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, SIMDType::size()> lanes;
+    std::copy_n(yold.begin() + (std::ptrdiff_t)firstChannel, lanes.size(), lanes.begin());
+
+    return SIMDType::fromRawArray(lanes.data());
+}
+
+template <typename SampleType>
+void MyEnvelopeDetector<SampleType>::storeState(size_t firstChannel, SIMDType state) noexcept
+{
+    jassert(firstChannel + SIMDType::size() <= yold.size());
+
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, SIMDType::size()> lanes;
+    state.copyToRawArray(lanes.data());
+
+    std::copy(lanes.begin(), lanes.end(), yold.begin() + (std::ptrdiff_t)firstChannel);
+}
+
+template <typename SampleType>
+bool MyEnvelopeDetector<SampleType>::isHolding() const noexcept
+{
+    return cteAT == static_cast<SampleType> (1.0) && cteRL == static_cast<SampleType> (1.0);
+}
+
 template <typename SampleType>
 SampleType MyEnvelopeDetector<SampleType>::calculateLimitedCte(SampleType timeMs) const noexcept
 {
@@ -105,6 +433,67 @@ SampleType MyEnvelopeDetector<SampleType>::calculateLimitedCte(SampleType timeMs
         : static_cast<SampleType> (std::exp(TC / (timeMs * sampleRate * 0.001)));//static_cast<SampleType> (std::exp (expFactor / timeMs));
 }
 
+template <typename SampleType>
+SampleType MyEnvelopeDetector<SampleType>::calculateLimitedCte(SampleType timeMs, int mode, double sampleRate) noexcept
+{
+    return timeMs < static_cast<SampleType> (1.0e-3) ? 0
+        : static_cast<SampleType> (std::exp(getTimeConstant(mode) / (timeMs * sampleRate * 0.001)));
+}
+
+template <typename SampleType>
+double MyEnvelopeDetector<SampleType>::getDecayTime(double releaseTimeMs, int mode, LevelCalculationType type,
+                                                    double rmsWindowTimeMs) noexcept
+{
+    const auto timeConstant = getTimeConstant(mode);
+
+    if (timeConstant == 0.0)
+        return 0.0;
+
+    // The state is multiplied by exp (timeConstant / releaseSamples) per
+    // sample. A mean square starts from full scale too but has to fall to the
+    // square of the silence level, and a window first has to empty.
+    const auto isMeanSquare = type != LevelCalculationType::peak;
+    const auto logTarget = std::log(silenceLevel) * (isMeanSquare ? 2.0 : 1.0);
+    const auto windowTime = type == LevelCalculationType::windowedRMS ? rmsWindowTimeMs * 0.001 : 0.0;
+
+    return windowTime + logTarget / timeConstant * releaseTimeMs * 0.001;
+}
+
+template <typename SampleType>
+bool MyEnvelopeDetector<SampleType>::isSilent() const noexcept
+{
+    const auto floor = static_cast<SampleType> (levelType == LevelCalculationType::peak ? silenceLevel
+                                                                                      : silenceLevel * silenceLevel);
+
+    for (auto old : yold)
+        if (old > floor)
+            return false;
+
+    if (levelType == LevelCalculationType::windowedRMS)
+        for (auto sum : rmsSums)
+            if (sum * rmsWindowLengthInverse > floor)
+                return false;
+
+    return true;
+}
+
+template <typename SampleType>
+double MyEnvelopeDetector<SampleType>::getTimeConstant(int mode) noexcept
+{
+    // Normal RC: one time constant reaches 63.2 % (1 - 0.368) of a step.
+    // Procentual RC: the time is measured between 10 % and 90 % of a step.
+    // Level RC: a zero time constant, which gives a coefficient of 1 so the
+    // envelope holds its value.
+    const auto normal = std::log(0.368);
+
+    switch (mode)
+    {
+        case 0:  return normal;
+        case 1:  return normal * std::log(9.0);
+        default: return 0.0;
+    }
+}
+
 //==============================================================================
 template class MyEnvelopeDetector<float>;
 template class MyEnvelopeDetector<double>;
\ No newline at end of file
@@ -1,8 +1,13 @@
+#pragma once
+
 #include <JuceHeader.h>
+#include "MyCpuDispatch.h"
+
 enum class BallisticsFilterLevelCalculationType
 {
     peak,
-    RMS
+    RMS,
+    windowedRMS
 };
 
 /**
@@ -18,6 +23,7 @@ class MyEnvelopeDetector
 public:
     //==============================================================================
     using LevelCalculationType = BallisticsFilterLevelCalculationType;
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
 
     //==============================================================================
     /** Constructor. */
@@ -50,9 +56,32 @@ public:
         an RMS (root mean squared) implementation of the ballistics filter instead.
         This is useful in some compressor and noise-gate designs, or in specific
         types of volume meters.
+
+        The windowed RMS implementation averages the squared signal over a
+        rectangular window (see setRMSWindowTime()) before the ballistics,
+        which gives the same readings as an RMS meter with that integration
+        time.
+
+        Changing the type resets the filter.
     */
     void setLevelCalculationType(LevelCalculationType newCalculationType);
 
+    /** Sets the window length in ms of the windowed RMS level calculation.
+
+        The length is limited to maximumRMSWindowTime, for which prepare()
+        allocates the window. Changing the length clears the window.
+    */
+    void setRMSWindowTime(SampleType windowTimeMs);
+
+    /** Sets the window length in samples of the windowed RMS level calculation,
+        limited to the length allocated by prepare(). Like setCoefficients() this
+        can be called on the audio thread.
+    */
+    void setRMSWindowLength(int numSamples) noexcept;
+
+    /** The longest RMS window in ms that prepare() allocates for. */
+    static constexpr double maximumRMSWindowTime = 500.0;
+
     //==============================================================================
     /** Initialises the filter. */
     void prepare(const juce::dsp::ProcessSpec& spec);
@@ -65,6 +94,45 @@ public:
 
     void setTC(int mode); 
 
+    /** Sets attack and release coefficients that were computed in advance with
+        calculateLimitedCte(), together with the settings they were computed from.
+
+        Unlike the other setters this performs no transcendental math, so it can
+        be called on the audio thread.
+    */
+    void setCoefficients(SampleType attackTimeMs, SampleType releaseTimeMs, int mode,
+                         SampleType attackCoefficient, SampleType releaseCoefficient) noexcept;
+
+    /** Returns the time constant used by an RC mode (see setTC()). */
+    static double getTimeConstant(int mode) noexcept;
+
+    /** Returns the attack or release coefficient for a time in ms, an RC mode
+        and a sample rate.
+    */
+    static SampleType calculateLimitedCte(SampleType timeMs, int mode, double sampleRate) noexcept;
+
+    /** The level in gain below which the envelope counts as silent, -120 dB.
+        This is far above the denormal range in both precisions, also for the
+        mean squares of the RMS modes.
+    */
+    static constexpr double silenceLevel = 1.0e-6;
+
+    /** silenceLevel in dB. */
+    static constexpr double silenceLeveldB = -120.0;
+
+    /** Returns the time in seconds the envelope takes to fall from full scale
+        to silenceLevel once the input stops, for a release time in ms, an RC
+        mode and a level calculation type. In the level RC mode the envelope
+        holds its value and this is 0.
+    */
+    static double getDecayTime(double releaseTimeMs, int mode, LevelCalculationType type, double rmsWindowTimeMs) noexcept;
+
+    /** Returns true if the envelope of every channel is below silenceLevel,
+        including what is still in the RMS window. A silent envelope fed with
+        input below silenceLevel stays silent.
+    */
+    bool isSilent() const noexcept;
+
     //==============================================================================
     /** Processes the input and output samples supplied in the processing context. */
     template <typename ProcessContext>
@@ -87,11 +155,13 @@ public:
 
         for (size_t channel = 0; channel < numChannels; ++channel)
         {
-            auto* inputSamples = inputBlock.getChannelPointer(channel);
             auto* outputSamples = outputBlock.getChannelPointer(channel);
 
-            for (size_t i = 0; i < numSamples; ++i)
-                outputSamples[i] = processSample((int)channel, inputSamples[i]);
+            processEnvelope(channel, inputBlock.getChannelPointer(channel), outputSamples, numSamples);
+
+            if (levelType != LevelCalculationType::peak)
+                for (size_t i = 0; i < numSamples; ++i)
+                    outputSamples[i] = std::sqrt(outputSamples[i]);
         }
 
 #if JUCE_DSP_ENABLE_SNAP_TO_ZERO
@@ -99,6 +169,19 @@ public:
 #endif
     }
 
+    /** Writes the envelope of a whole block of one channel into a buffer
+        supplied by the caller, which may be the input buffer.
+
+        This is the block form of processSample(): the state stays in a
+        register across the block and the attack/release choice is a select
+        rather than a branch. The loop is compiled once for every level
+        calculation type and ballistics topology, and the one matching the
+        current settings is picked once per call. In both RMS modes the result
+        is the mean square level, the caller is responsible for any square
+        root. Call snapToZero() once per block afterwards.
+    */
+    void processEnvelope(size_t channel, const SampleType* input, SampleType* envelope, size_t numSamples) noexcept;
+
     /** Processes one sample at a time on a given channel. */
     SampleType processSample(int channel, SampleType inputValue);
 
@@ -108,26 +191,149 @@ public:
     */
     void snapToZero() noexcept;
 
+    //==============================================================================
+    /** Returns the state of SIMDType::size() consecutive channels starting at
+        firstChannel, packed into one vector register.
+    */
+    SIMDType loadState(size_t firstChannel) const noexcept;
+
+    /** Writes back a channel state previously obtained with loadState(). */
+    void storeState(size_t firstChannel, SIMDType state) noexcept;
+
+    /** Processes one sample frame of several channels side by side, one channel
+        per vector lane.
+
+        This performs the same arithmetic as processSample(), with the
+        attack/release selection done with a lane mask instead of a branch. The
+        state is held by the caller (see loadState()) so it can stay in a
+        register for a whole block. In both RMS modes the returned value is the
+        mean square level: the caller is responsible for taking the square root.
+    */
+    SIMDType processLanes(SIMDType inputValue, SIMDType& state) const noexcept
+    {
+        // In windowed RMS mode the input already is a mean square,
+        // see processWindowLanes()
+        if (levelType == LevelCalculationType::RMS)
+            inputValue = inputValue * inputValue;
+        else if (levelType == LevelCalculationType::peak)
+            inputValue = SIMDType::abs(inputValue);
+
+        const auto isAttack = SIMDType::greaterThan(inputValue, state);
+        const auto cte = (SIMDType::expand(cteAT) & isAttack) + (SIMDType::expand(cteRL) & ~isAttack);
+
+        state = inputValue + cte * (state - inputValue);
+        return state;
+    }
+
+    /** Computes the windowed mean square of one block of interleaved sample
+        frames (see processLanes()) of the SIMDType::size() channels starting at
+        firstChannel, which must be a multiple of SIMDType::size().
+
+        The squares of all lanes are added to and removed from the running sums
+        side by side. The result is the level to pass to processLanes() in
+        windowed RMS mode.
+    */
+    void processWindowLanes(size_t firstChannel, const SampleType* frames, SampleType* meanSquares, size_t numFrames) noexcept;
+
+    /** Writes the envelope of a block of interleaved sample frames (see
+        processLanes()) of the SIMDType::size() channels starting at
+        firstChannel into a buffer supplied by the caller, which may be frames.
+
+        This runs the windowed RMS stage when it is selected, then the
+        ballistics with the attack/release choice done by lane masks, keeping
+        the state in a register for the whole block. Like processEnvelope() it
+        dispatches once per call to a loop specialised for the current
+        settings. As with processLanes() the RMS modes return mean squares.
+        Call snapToZero() once per block afterwards.
+    */
+    void processEnvelopeLanes(size_t firstChannel, const SampleType* frames, SampleType* envelope, size_t numFrames) noexcept;
+
+    /** Returns the current level calculation type. */
+    LevelCalculationType getLevelCalculationType() const noexcept { return levelType; }
+
 private:
     //==============================================================================
     SampleType calculateLimitedCte(SampleType) const noexcept;
 
+    /** True when both coefficients are 1, as in the level RC mode (see
+        getTimeConstant()), so the envelope holds its value whatever the input.
+    */
+    bool isHolding() const noexcept;
+
+    /** The loops behind processEnvelope() and processEnvelopeLanes(), with the
+        level calculation and the ballistics topology fixed at compile time.
+        A holding envelope is written as it is, rather than through the one
+        pole formula which could drift by rounding.
+    */
+    template <LevelCalculationType type, bool holding>
+    void processEnvelopeKernel(size_t channel, const SampleType* input, SampleType* envelope, size_t numSamples) noexcept;
+
+    template <LevelCalculationType type, bool holding>
+    void processEnvelopeLanesKernel(size_t firstChannel, const SampleType* frames, SampleType* envelope, size_t numFrames) noexcept;
+
+    /** The kernels above, inlined into code compiled for an instruction set
+        (see MyCpuDispatch), which prepare() picks.
+    */
+    template <InstructionSet isa, LevelCalculationType type, bool holding>
+    void processEnvelopeFor(size_t channel, const SampleType* input, SampleType* envelope, size_t numSamples) noexcept;
+
+    template <InstructionSet isa, LevelCalculationType type, bool holding>
+    void processEnvelopeLanesFor(size_t firstChannel, const SampleType* frames, SampleType* envelope, size_t numFrames) noexcept;
+
+    using Kernel = void (MyEnvelopeDetector::*)(size_t, const SampleType*, SampleType*, size_t) noexcept;
+
+    /** The single channel and the lanes kernel for one combination of
+        instruction set, level calculation type and ballistics topology.
+    */
+    struct Kernels
+    {
+        Kernel envelope, envelopeLanes;
+    };
+
+    template <InstructionSet isa, LevelCalculationType type, bool holding>
+    static constexpr Kernels makeKernels() noexcept
+    {
+        return { &MyEnvelopeDetector::processEnvelopeFor<isa, type, holding>,
+                 &MyEnvelopeDetector::processEnvelopeLanesFor<isa, type, holding> };
+    }
+
+    /** Looks up the kernels for the current settings, once per call. */
+    Kernels getKernels() const noexcept;
+
+    template <InstructionSet isa>
+    Kernels getKernelsFor() const noexcept;
+
+    SampleType processWindowSample(size_t channel, SampleType square) noexcept;
+    SIMDType sumWindowLanes(const SampleType* window) const noexcept;
+    void resetWindow() noexcept;
+
     //==============================================================================
     std::vector<SampleType> yold;
 
+    // Windowed RMS: the last rmsWindowLength squares of every channel, stored
+    // interleaved by channel group like the frames of processLanes(), plus a
+    // running sum and a write position per channel. The sums are recomputed
+    // from the window every time the position wraps, so rounding errors of the
+    // running update cannot build up.
+    std::vector<SampleType> rmsWindowStorage;
+    SampleType* rmsWindow = nullptr;
+    std::vector<SampleType> rmsSums;
+    std::vector<size_t> rmsPositions;
+    size_t rmsWindowCapacity = 0, rmsWindowLength = 1;
+    SampleType rmsWindowTime = 300.0, rmsWindowLengthInverse = 1.0;
 
-    
-    double TC_normal = log(0.368);
-    double TC_10_90 = TC_normal * log(9);
 
-    std::array<double, 3> TC_MAP = { TC_normal, TC_10_90, (double)0.0 };
+    
+    std::array<double, 3> TC_MAP = { getTimeConstant(0), getTimeConstant(1), getTimeConstant(2) };
 
-    double TC = TC_normal;
+    double TC = TC_MAP[0];
+    int tcMode = 0;
 
 
     double sampleRate = 44100.0, expFactor = -0.142;
     
     SampleType attackTime = 1.0, releaseTime = 100.0, cteAT = 0.0, cteRL = 0.0;
     LevelCalculationType levelType = LevelCalculationType::peak;
+    InstructionSet instructionSet = InstructionSet::generic;
 };
 
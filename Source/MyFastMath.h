@@ -0,0 +1,115 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Polynomial approximations of log2 and exp2, used by the gain computer of
+    MyCompressor in GainComputerPrecision::fast mode.
+
+    Both functions split their argument into exponent and mantissa with integer
+    bit operations and evaluate a degree 5 polynomial on the mantissa, fitted at
+    Chebyshev nodes. The polynomials are constrained so that log2 (1) == 0 and
+    exp2 (0) == 1 exactly, which keeps a unity gain exact below the threshold.
+
+    Maximum absolute error over the normal range, in log2 units:
+    log2: 5.0e-5, exp2: 3.0e-7 plus the float rounding of its argument. With a
+    compressor slope of at most 1 this bounds the gain error to
+    6.02 * (5.0e-5 + 3.0e-7) < 0.0005 dB.
+
+    The approximations are always evaluated in single precision, which is far
+    more accurate than the polynomials themselves; this keeps the double
+    instantiation vectorisable on SSE2, which has no 64 bit integer compares or
+    conversions. All clamping is done on the integer representation, because
+    compilers will not if-convert floating point comparisons under the default
+    trapping math rules, and a single float min/max would stop loops over these
+    functions from being vectorised.
+
+    @tags{DSP}
+*/
+template <typename SampleType>
+struct MyFastMath
+{
+    /** Approximates std::log2 (x). Non-positive and denormal inputs return the
+        log2 of the smallest normal float.
+    */
+    static SampleType log2(SampleType x) noexcept
+    {
+        auto bits = toBits(static_cast<float> (x));
+        bits = bits < minNormalBits ? minNormalBits : bits;
+
+        const auto exponent = static_cast<float> ((bits >> mantissaBits) - exponentBias);
+        const auto t = fromBits((bits & mantissaMask) | oneBits) - 1.0f;
+
+        return static_cast<SampleType> (exponent + t * (1.4426038942423591f
+                                                 + t * (-0.7167146631676422f
+                                                 + t * (0.44059903295532005f
+                                                 + t * (-0.22510302549827224f
+                                                 + t *  0.0586649397156539f)))));
+    }
+
+    /** Approximates std::exp2 (x) for |x| < 2^22. Results outside the normal
+        float range are clamped to it.
+    */
+    static SampleType exp2(SampleType x) noexcept
+    {
+        const auto xf = static_cast<float> (x);
+
+        // Round to the nearest integer by pushing the fraction out of the mantissa
+        const auto shifted = xf + roundingMagic;
+        const auto f = xf - (shifted - roundingMagic);
+
+        auto integer = toBits(shifted) - toBits(roundingMagic);
+        integer = integer < 1 - exponentBias ? 1 - exponentBias : integer;
+        integer = integer > exponentBias ? exponentBias : integer;
+
+        const auto result = 1.0f + f * (0.6931471805599452f
+                                 + f * (0.24022349038020277f
+                                 + f * (0.05550381013796419f
+                                 + f * (0.009666368515388853f
+                                 + f *  0.001338130253736246f))));
+
+        return static_cast<SampleType> (fromBits(toBits(result) + integer * (1 << mantissaBits)));
+    }
+
+    /** Returns max (x, 0), without a floating point comparison. */
+    static SampleType positivePart(SampleType x) noexcept
+    {
+        auto bits = toBits(static_cast<float> (x));
+        return static_cast<SampleType> (fromBits(bits < 0 ? 0 : bits));
+    }
+
+    /** Applies log2() to an array in place. */
+    static void log2(SampleType* values, size_t numValues) noexcept
+    {
+        for (size_t i = 0; i < numValues; ++i)
+            values[i] = log2(values[i]);
+    }
+
+    /** Applies exp2() to an array in place. */
+    static void exp2(SampleType* values, size_t numValues) noexcept
+    {
+        for (size_t i = 0; i < numValues; ++i)
+            values[i] = exp2(values[i]);
+    }
+
+private:
+    static int32_t toBits(float x) noexcept
+    {
+        int32_t bits;
+        std::memcpy(&bits, &x, sizeof(x));
+        return bits;
+    }
+
+    static float fromBits(int32_t bits) noexcept
+    {
+        float x;
+        std::memcpy(&x, &bits, sizeof(x));
+        return x;
+    }
+
+    static constexpr int mantissaBits = 23, exponentBias = 127;
+    static constexpr int32_t mantissaMask = (1 << mantissaBits) - 1;
+    static constexpr int32_t oneBits = exponentBias << mantissaBits;
+    static constexpr int32_t minNormalBits = 1 << mantissaBits;
+    static constexpr float roundingMagic = 12582912.0f; // 1.5 * 2^23
+};
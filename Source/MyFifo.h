@@ -0,0 +1,64 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    A wait-free single producer, single consumer queue of a fixed capacity,
+    typically for passing values from the audio thread to the message thread.
+
+    The storage lives inside the object, so pushing and popping never allocate
+    or lock. When the queue is full push() drops the value and returns false;
+    a reader that falls behind loses the newest values rather than stalling
+    the writer.
+
+    @tags{DSP}
+*/
+template <typename ValueType, int capacity>
+class MyFifo
+{
+public:
+    //==============================================================================
+    /** Adds a value, or returns false if the queue is full. Call this from the
+        writer thread only.
+    */
+    bool push(const ValueType& value) noexcept
+    {
+        if (fifo.getFreeSpace() == 0)
+            return false;
+
+        fifo.write(1).forEach([this, &value](int index) { values[(size_t)index] = value; });
+        return true;
+    }
+
+    /** Removes the oldest value, or returns false if the queue is empty. Call
+        this from the reader thread only.
+    */
+    bool pop(ValueType& value) noexcept
+    {
+        if (fifo.getNumReady() == 0)
+            return false;
+
+        fifo.read(1).forEach([this, &value](int index) { value = values[(size_t)index]; });
+        return true;
+    }
+
+    /** Removes every value that is ready, oldest first, passing each to the
+        callback. Returns the number of values removed.
+    */
+    template <typename Callback>
+    int drain(Callback&& callback)
+    {
+        const auto numReady = fifo.getNumReady();
+        fifo.read(numReady).forEach([this, &callback](int index) { callback(values[(size_t)index]); });
+        return numReady;
+    }
+
+    /** Discards everything in the queue. Only safe while neither side is using it. */
+    void reset() noexcept { fifo.reset(); }
+
+private:
+    //==============================================================================
+    // AbstractFifo keeps one slot free to tell a full queue from an empty one
+    juce::AbstractFifo fifo{ capacity + 1 };
+    std::array<ValueType, (size_t)capacity + 1> values{};
+};
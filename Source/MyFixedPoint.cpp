@@ -0,0 +1,21 @@
+#include <JuceHeader.h>
+#include "MyFixedPoint.h"
+
+//==============================================================================
+static MyFixedPoint::Tables createTables() noexcept
+{
+    MyFixedPoint::Tables t;
+    constexpr auto numSegments = (double)(MyFixedPoint::tableSize - 1);
+
+    for (size_t i = 0; i < MyFixedPoint::tableSize; ++i)
+    {
+        const auto x = (double)i / numSegments;
+        t.log2[i] = (juce::int32)std::llround(std::log2(1.0 + x) * (double)(1 << MyFixedPoint::log2FractionalBits));
+        t.exp2[i] = (juce::uint32)std::llround(std::exp2(x) * (double)MyFixedPoint::unityGain);
+    }
+
+    return t;
+}
+
+// Filled once at start-up, so that log2() and exp2() never touch floating point
+const MyFixedPoint::Tables MyFixedPoint::tables = createTables();
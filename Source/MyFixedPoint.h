@@ -0,0 +1,194 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Q-format integer arithmetic for MyFixedPointCompressor, for targets
+    without a fast floating point unit.
+
+    A Qm.n number is a signed integer with n fractional bits and m integer
+    bits including the sign, so Q1.31 covers [-1, 1) in steps of 2^-31. The
+    formats used are:
+
+    - audio: Q1.31 in an int32.
+    - envelopes: Q1.63 in an int64, whose upper half is the envelope in
+      Q1.31. Envelopes are never negative.
+    - log2 values: Q8.24 in an int32, so [-128, 128).
+    - gains: Q2.30 in an int32, so that a gain of exactly 1 exists and a unity
+      gain leaves every sample unchanged.
+    - detector coefficients: Q32.32 in an int64, in [0, 1].
+
+    Rounding and saturation are defined, and the same on every target:
+    products are rounded to the nearest value with ties towards plus infinity
+    (add half an LSB, then shift arithmetically right), unless a function says
+    otherwise, and results that do not fit their format saturate to its range.
+    The only value whose magnitude does not fit Q1.31 is -1, so abs() and
+    square() of it saturate to the largest positive value.
+
+    log2() and exp2() interpolate linearly in tables of 2^tableBits segments,
+    4 kB each. Their maximum errors, in log2 units, are 2.2e-7 for log2() and
+    7.5e-7 for exp2() above -60 dB, below which one LSB of the Q2.30 result
+    dominates. This keeps the gain of the compressor within 0.00001 dB of the
+    exact static curve.
+
+    @tags{DSP}
+*/
+struct MyFixedPoint
+{
+    //==============================================================================
+    static constexpr int audioFractionalBits = 31;
+    static constexpr int log2FractionalBits = 24;
+    static constexpr int gainFractionalBits = 30;
+    static constexpr int coefficientFractionalBits = 32;
+
+    static constexpr juce::int32 unityGain = 1 << gainFractionalBits;
+    static constexpr juce::int64 unityCoefficient = (juce::int64)1 << coefficientFractionalBits;
+
+    static constexpr int tableBits = 10;
+    static constexpr size_t tableSize = ((size_t)1 << tableBits) + 1;
+
+    //==============================================================================
+    /** Clamps a value to the range of a signed integer of a number of bits. */
+    template <int numBits>
+    static juce::int64 saturate(juce::int64 x) noexcept
+    {
+        constexpr auto maximum = ((juce::int64)1 << (numBits - 1)) - 1;
+        return x > maximum ? maximum : (x < -maximum - 1 ? -maximum - 1 : x);
+    }
+
+    /** Divides by 2^shift, rounding to nearest with ties towards plus infinity.
+        shift must be at least 1.
+    */
+    static juce::int64 roundingShift(juce::int64 x, int shift) noexcept
+    {
+        return (x + ((juce::int64)1 << (shift - 1))) >> shift;
+    }
+
+    /** Returns |x| of a Q1.31 value. */
+    static juce::int32 abs(juce::int32 x) noexcept
+    {
+        return x < 0 ? (x == std::numeric_limits<juce::int32>::min() ? std::numeric_limits<juce::int32>::max() : -x) : x;
+    }
+
+    /** Returns x * x of a Q1.31 value, rounded. */
+    static juce::int32 square(juce::int32 x) noexcept
+    {
+        return (juce::int32)saturate<32>(roundingShift((juce::int64)x * x, audioFractionalBits));
+    }
+
+    //==============================================================================
+    /** Returns log2 (x) in Q8.24 of a positive Q1.31 value, so a result in
+        [-31, 0). Zero and negative values return the log2 of one LSB, -31.
+    */
+    static juce::int32 log2(juce::int32 x) noexcept
+    {
+        constexpr int remainderBits = 31 - tableBits;
+
+        const auto value = (juce::uint32)(x < 1 ? 1 : x);
+        const auto exponent = juce::findHighestSetBit(value);
+
+        // The mantissa in [1, 2) as 1.31 unsigned, then its fraction split
+        // into a table index and the position between two entries
+        const auto fraction = (value << (31 - exponent)) & 0x7fffffffu;
+        const auto index = fraction >> remainderBits;
+        const auto remainder = (juce::int64)(fraction & ((1u << remainderBits) - 1));
+
+        const auto t0 = tables.log2[index];
+        const auto t1 = tables.log2[index + 1];
+
+        return (exponent - audioFractionalBits) * (1 << log2FractionalBits)
+             + t0 + (juce::int32)roundingShift((juce::int64)(t1 - t0) * remainder, remainderBits);
+    }
+
+    /** Returns 2^x in Q2.30 of a Q8.24 value x <= 0, so a result in [0, 1]. */
+    static juce::int32 exp2(juce::int32 x) noexcept
+    {
+        jassert(x <= 0);
+
+        constexpr int remainderBits = log2FractionalBits - tableBits;
+
+        // x = fraction - shift, with the fraction in [0, 1)
+        const auto shift = juce::jmin(-(x >> log2FractionalBits), 62);
+        const auto fraction = (juce::uint32)x & ((1u << log2FractionalBits) - 1);
+        const auto index = fraction >> remainderBits;
+        const auto remainder = (juce::int64)(fraction & ((1u << remainderBits) - 1));
+
+        const auto t0 = tables.exp2[index];
+        const auto t1 = tables.exp2[index + 1];
+        const auto mantissa = (juce::int64)t0 + roundingShift((juce::int64)(t1 - t0) * remainder, remainderBits);
+
+        // mantissa / 2^shift, rounded; shift is 0 only for x == 0
+        return (juce::int32)roundingShift(mantissa * 2, shift + 1);
+    }
+
+    //==============================================================================
+    /** log2 (1 + i / 2^tableBits) in Q8.24, and 2^(i / 2^tableBits) in Q2.30
+        as an unsigned value, for i in [0, 2^tableBits].
+    */
+    struct Tables
+    {
+        std::array<juce::int32, tableSize> log2;
+        std::array<juce::uint32, tableSize> exp2;
+    };
+
+    static const Tables tables;
+};
+
+//==============================================================================
+/** A sample of 24 bit PCM packed into three bytes, little endian first, as in
+    WAV files and packed I2S frames.
+*/
+struct MyInt24
+{
+    juce::uint8 bytes[3];
+};
+
+/**
+    Reads and writes the PCM sample types MyFixedPointCompressor processes:
+    juce::int16, MyInt24 and juce::int32. read() returns the integer value of
+    a sample, and write() stores a value, saturated to the range of the type.
+    numBits is the width of the values.
+
+    @tags{DSP}
+*/
+template <typename PCMType>
+struct MyPCMFormat;
+
+template <>
+struct MyPCMFormat<juce::int16>
+{
+    static constexpr int numBits = 16;
+
+    static juce::int32 read(const juce::int16& sample) noexcept { return sample; }
+    static void write(juce::int16& sample, juce::int64 value) noexcept { sample = (juce::int16)MyFixedPoint::saturate<numBits>(value); }
+};
+
+template <>
+struct MyPCMFormat<MyInt24>
+{
+    static constexpr int numBits = 24;
+
+    static juce::int32 read(const MyInt24& sample) noexcept
+    {
+        // Assemble in the top three bytes, then sign extend
+        const auto bits = ((juce::uint32)sample.bytes[0] << 8) | ((juce::uint32)sample.bytes[1] << 16) | ((juce::uint32)sample.bytes[2] << 24);
+        return (juce::int32)bits >> 8;
+    }
+
+    static void write(MyInt24& sample, juce::int64 value) noexcept
+    {
+        const auto bits = (juce::uint32)MyFixedPoint::saturate<numBits>(value);
+        sample.bytes[0] = (juce::uint8)bits;
+        sample.bytes[1] = (juce::uint8)(bits >> 8);
+        sample.bytes[2] = (juce::uint8)(bits >> 16);
+    }
+};
+
+template <>
+struct MyPCMFormat<juce::int32>
+{
+    static constexpr int numBits = 32;
+
+    static juce::int32 read(const juce::int32& sample) noexcept { return sample; }
+    static void write(juce::int32& sample, juce::int64 value) noexcept { sample = (juce::int32)MyFixedPoint::saturate<numBits>(value); }
+};
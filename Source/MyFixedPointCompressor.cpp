@@ -0,0 +1,232 @@
+#include <JuceHeader.h>
+#include "MyFixedPointCompressor.h"
+
+//==============================================================================
+void MyFixedPointCompressor::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels > 0);
+
+    numChannels = spec.numChannels;
+    state.resize(numChannels);
+    minimumGain.resize(numChannels);
+    channelScale = ((juce::int64)1 << MyFixedPoint::audioFractionalBits) / (juce::int64)numChannels;
+
+    reset();
+}
+
+void MyFixedPointCompressor::reset() noexcept
+{
+    std::fill(state.begin(), state.end(), (juce::int64)0);
+    std::fill(minimumGain.begin(), minimumGain.end(), MyFixedPoint::unityGain);
+}
+
+juce::int32 MyFixedPointCompressor::getMinimumGain(int channel) const noexcept
+{
+    jassert(juce::isPositiveAndBelow(channel, (int)numChannels));
+    return minimumGain[(size_t)channel];
+}
+
+//==============================================================================
+void MyFixedPointCompressor::setCoefficients(const MyCompressorCoefficients& newCoefficients) noexcept
+{
+    const auto& c = newCoefficients;
+
+    auto toCoefficient = [](double cte)
+    {
+        return (juce::int64)std::llround(juce::jlimit(0.0, 1.0, cte) * (double)MyFixedPoint::unityCoefficient);
+    };
+
+    auto toLevel = [](double level)
+    {
+        constexpr auto maximum = std::numeric_limits<juce::int32>::max();
+        return (juce::int32)juce::jmin((long long)maximum, std::llround(level * (double)((juce::int64)1 << MyFixedPoint::audioFractionalBits)));
+    };
+
+    cteAT = toCoefficient(c.cteAT);
+    cteRL = toCoefficient(c.cteRL);
+
+    const auto reducesGain = c.ratioInverse < 1.0;
+    peakThreshold = reducesGain ? toLevel(c.threshold) : std::numeric_limits<juce::int32>::max();
+    meanSquareThreshold = reducesGain ? toLevel(c.threshold * c.threshold) : std::numeric_limits<juce::int32>::max();
+
+    // No envelope lies below -31, the log2 of one LSB, so lower thresholds
+    // make no difference. Limiting them keeps the overshoot in range.
+    const auto log2Thr = juce::jmax(-48.0, c.log2Threshold);
+    log2Threshold = (juce::int32)std::llround(log2Thr * (double)(1 << MyFixedPoint::log2FractionalBits));
+    meanSquareLog2Threshold = log2Threshold * 2;
+
+    slope = (juce::int32)std::llround(c.slope * (double)MyFixedPoint::unityGain);
+    meanSquareSlope = (juce::int32)std::llround(c.slope * 0.5 * (double)MyFixedPoint::unityGain);
+}
+
+void MyFixedPointCompressor::setLevelCalculationType(LevelCalculationType newType) noexcept
+{
+    // The windowed RMS detector needs a window per channel, use MyCompressor
+    jassert(newType != LevelCalculationType::windowedRMS);
+
+    if (newType != levelType)
+    {
+        levelType = newType;
+        reset();
+    }
+}
+
+void MyFixedPointCompressor::setLinkMode(ChannelLinkMode newLinkMode) noexcept
+{
+    // Weights would need a multiply per channel and sample, use MyCompressor
+    jassert(newLinkMode != ChannelLinkMode::weighted);
+
+    if (newLinkMode != linkMode)
+    {
+        linkMode = newLinkMode;
+        reset();
+    }
+}
+
+//==============================================================================
+template <typename PCMType>
+void MyFixedPointCompressor::process(const PCMType* const* inputs, PCMType* const* outputs, size_t numSamples) noexcept
+{
+    using Type = LevelCalculationType;
+    using Link = ChannelLinkMode;
+
+    // Indexed by level calculation type, then by link mode. The windowed RMS
+    // type runs as plain RMS, and the weighted link as the mean.
+    static constexpr Kernel<PCMType> kernels[3][4] = {
+        { &MyFixedPointCompressor::processKernel<PCMType, Type::peak, Link::none>, &MyFixedPointCompressor::processKernel<PCMType, Type::peak, Link::max>,
+          &MyFixedPointCompressor::processKernel<PCMType, Type::peak, Link::mean>, &MyFixedPointCompressor::processKernel<PCMType, Type::peak, Link::mean> },
+        { &MyFixedPointCompressor::processKernel<PCMType, Type::RMS, Link::none>, &MyFixedPointCompressor::processKernel<PCMType, Type::RMS, Link::max>,
+          &MyFixedPointCompressor::processKernel<PCMType, Type::RMS, Link::mean>, &MyFixedPointCompressor::processKernel<PCMType, Type::RMS, Link::mean> },
+        { &MyFixedPointCompressor::processKernel<PCMType, Type::RMS, Link::none>, &MyFixedPointCompressor::processKernel<PCMType, Type::RMS, Link::max>,
+          &MyFixedPointCompressor::processKernel<PCMType, Type::RMS, Link::mean>, &MyFixedPointCompressor::processKernel<PCMType, Type::RMS, Link::mean> }
+    };
+
+    (this->*kernels[(size_t)levelType][(size_t)linkMode])(inputs, outputs, numSamples);
+}
+
+template <typename PCMType, BallisticsFilterLevelCalculationType type, ChannelLinkMode link>
+forcedinline juce::int32 MyFixedPointCompressor::getKey(const PCMType* const* inputs, size_t channel, size_t index) const noexcept
+{
+    using Format = MyPCMFormat<PCMType>;
+
+    // Left aligned to Q1.31, which is exact
+    auto rectify = [&](size_t c)
+    {
+        return MyFixedPoint::abs((juce::int32)((juce::uint32)Format::read(inputs[c][index]) << (32 - Format::numBits)));
+    };
+
+    // The channels are combined before squaring, as in MyCompressor
+    juce::int32 key;
+
+    if constexpr (link == ChannelLinkMode::none)
+    {
+        key = rectify(channel);
+    }
+    else if constexpr (link == ChannelLinkMode::max)
+    {
+        key = rectify(0);
+
+        for (size_t c = 1; c < numChannels; ++c)
+            key = juce::jmax(key, rectify(c));
+    }
+    else
+    {
+        juce::int64 sum = 0;
+
+        for (size_t c = 0; c < numChannels; ++c)
+            sum += rectify(c);
+
+        key = (juce::int32)((sum * channelScale) >> MyFixedPoint::audioFractionalBits);
+    }
+
+    return type == LevelCalculationType::peak ? key : MyFixedPoint::square(key);
+}
+
+template <typename PCMType, BallisticsFilterLevelCalculationType type, ChannelLinkMode link>
+void MyFixedPointCompressor::processKernel(const PCMType* const* inputs, PCMType* const* outputs, size_t numSamples) noexcept
+{
+    using Format = MyPCMFormat<PCMType>;
+
+    constexpr auto isMeanSquare = type != LevelCalculationType::peak;
+    constexpr auto isLinked = link != ChannelLinkMode::none;
+
+    const auto threshold = isMeanSquare ? meanSquareThreshold : peakThreshold;
+    const auto log2Thr = isMeanSquare ? meanSquareLog2Threshold : log2Threshold;
+    const auto slopeValue = isMeanSquare ? meanSquareSlope : slope;
+
+    // A linked compressor runs one detector for all channels
+    const auto numDetectors = isLinked ? (size_t)1 : numChannels;
+
+    // The envelope of a block, then overwritten with the gain to apply
+    std::array<juce::int32, kernelBlockSize> gains;
+
+    for (size_t detector = 0; detector < numDetectors; ++detector)
+    {
+        const auto endChannel = isLinked ? numChannels : detector + 1;
+        auto env = state[detector];
+        auto minGain = MyFixedPoint::unityGain;
+
+        for (size_t start = 0; start < numSamples; start += kernelBlockSize)
+        {
+            const auto numFrames = juce::jmin(kernelBlockSize, numSamples - start);
+            auto isAbove = false;
+
+            // Detector pass, key + cte * (env - key) on the Q1.63 envelope.
+            // Multiplying only its upper half by the coefficient and adding
+            // the lower half unscaled errs by less than one Q1.31 LSB in
+            // total, and the envelope still holds exactly for a coefficient
+            // of 1.
+            for (size_t i = 0; i < numFrames; ++i)
+            {
+                const auto key = getKey<PCMType, type, link>(inputs, detector, start + i);
+                const auto upper = (juce::int32)(env >> 32);
+                const auto cte = key > upper ? cteAT : cteRL;
+
+                env = ((juce::int64)key << 32) + (juce::int64)(upper - key) * cte + (env & 0xffffffff);
+                gains[i] = (juce::int32)(env >> 32);
+                isAbove = isAbove || gains[i] > threshold;
+            }
+
+            // Below the threshold the gain is exactly 1
+            if (! isAbove)
+            {
+                for (auto channel = detector; channel < endChannel; ++channel)
+                    if (inputs[channel] != outputs[channel])
+                        std::copy(inputs[channel] + start, inputs[channel] + start + numFrames, outputs[channel] + start);
+
+                continue;
+            }
+
+            // Gain pass, see the class description
+            for (size_t i = 0; i < numFrames; ++i)
+            {
+                const auto overshoot = juce::jmax(0, MyFixedPoint::log2(gains[i]) - log2Thr);
+                const auto log2Gain = MyFixedPoint::roundingShift((juce::int64)overshoot * slopeValue, MyFixedPoint::gainFractionalBits);
+
+                gains[i] = MyFixedPoint::exp2((juce::int32)log2Gain);
+                minGain = juce::jmin(minGain, gains[i]);
+            }
+
+            // VCA, in the width of the PCM type and with a single rounding
+            for (auto channel = detector; channel < endChannel; ++channel)
+            {
+                const auto* input = inputs[channel] + start;
+                auto* output = outputs[channel] + start;
+
+                for (size_t i = 0; i < numFrames; ++i)
+                    Format::write(output[i], MyFixedPoint::roundingShift((juce::int64)Format::read(input[i]) * gains[i],
+                                                                         MyFixedPoint::gainFractionalBits));
+            }
+        }
+
+        state[detector] = env;
+
+        for (auto channel = detector; channel < endChannel; ++channel)
+            minimumGain[channel] = minGain;
+    }
+}
+
+//==============================================================================
+template void MyFixedPointCompressor::process<juce::int16>(const juce::int16* const*, juce::int16* const*, size_t) noexcept;
+template void MyFixedPointCompressor::process<MyInt24>(const MyInt24* const*, MyInt24* const*, size_t) noexcept;
+template void MyFixedPointCompressor::process<juce::int32>(const juce::int32* const*, juce::int32* const*, size_t) noexcept;
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MyCompressor.h"
+#include "MyFixedPoint.h"
+
+/**
+    A compressor in integer arithmetic only, for embedded targets without a
+    fast floating point unit, processing 16, 24 or 32 bit PCM in place of
+    float buffers.
+
+    The samples are read as integers and never converted to floating point:
+    the detector sees them in Q1.31 (see MyFixedPoint), runs the attack and
+    release filter of MyEnvelopeDetector on a Q1.63 envelope, and the gain
+    computer evaluates the static curve of MyCompressor in the log2 domain,
+
+        gain = 2 ^ ((1 / ratio - 1) * max (log2 (env) - log2 (threshold), 0)),
+
+    with the table driven MyFixedPoint::log2() and exp2(). The gain is a
+    Q2.30 value, which the VCA multiplies with the sample in its own width and
+    rounds once, so a unity gain passes a sample through unchanged.
+
+    The result follows the float engine to within the resolution of 16 bit
+    PCM, and to within 2^-20 of full scale for the wider types: the gain is
+    within 0.00001 dB of the exact curve, the envelope within 2^-31 of full
+    scale, and the VCA rounds the output once. CompressorBenchmark --verify
+    checks these bounds against MyCompressor<double>. The
+    envelope has 63 fractional bits because with only 31 the rounding of
+    every filter step would add up, to an error of about 1 / (1 - cte) LSBs
+    for a coefficient cte, or 10^4 for a release of 200 ms at 48 kHz. The
+    key of the RMS detector is a mean square in Q1.31, so it resolves levels
+    down to about -90 dBFS.
+
+    Like MyCompressorBank this has no lookahead, key filter, windowed RMS
+    detector or control rate mode. The channels can be linked with the max and
+    mean modes of ChannelLinkMode.
+
+    The coefficients come from MyCompressorCoefficients::calculate(), like for
+    the float engines. setCoefficients() converts them with a handful of
+    floating point operations and no transcendental math; on a target without
+    an FPU call it on a thread where that does not matter.
+
+    @tags{DSP}
+*/
+class MyFixedPointCompressor
+{
+public:
+    //==============================================================================
+    using LevelCalculationType = BallisticsFilterLevelCalculationType;
+
+    /** Number of samples per channel the kernel works on at a time. */
+    static constexpr size_t kernelBlockSize = 64;
+
+    //==============================================================================
+    /** Allocates the state for spec.numChannels channels and resets it. The
+        sample rate is carried by the coefficients.
+    */
+    void prepare(const juce::dsp::ProcessSpec& spec);
+
+    /** Clears the envelopes. */
+    void reset() noexcept;
+
+    /** Returns the number of channels given to prepare(). */
+    int getNumChannels() const noexcept { return (int)numChannels; }
+
+    //==============================================================================
+    /** Applies a set of coefficients. The lookahead, key filter, control rate
+        and RMS window settings in them are ignored.
+    */
+    void setCoefficients(const MyCompressorCoefficients& newCoefficients) noexcept;
+
+    /** Sets the level calculation type, peak or RMS. Changing the type resets
+        the envelopes.
+    */
+    void setLevelCalculationType(LevelCalculationType newType) noexcept;
+
+    /** Sets how the channels are linked: none, max or mean. Changing the mode
+        resets the envelopes.
+    */
+    void setLinkMode(ChannelLinkMode newLinkMode) noexcept;
+
+    //==============================================================================
+    /** Processes numSamples samples of every channel given to prepare(). The
+        input and output may be the same buffers.
+
+        PCMType is juce::int16, MyInt24 or juce::int32, see MyPCMFormat.
+    */
+    template <typename PCMType>
+    void process(const PCMType* const* inputs, PCMType* const* outputs, size_t numSamples) noexcept;
+
+    /** Returns the smallest gain a channel applied during the last call to
+        process(), in Q2.30, for a gain reduction meter.
+    */
+    juce::int32 getMinimumGain(int channel) const noexcept;
+
+private:
+    //==============================================================================
+    template <typename PCMType>
+    using Kernel = void (MyFixedPointCompressor::*)(const PCMType* const*, PCMType* const*, size_t) noexcept;
+
+    template <typename PCMType, LevelCalculationType levelType, ChannelLinkMode link>
+    void processKernel(const PCMType* const* inputs, PCMType* const* outputs, size_t numSamples) noexcept;
+
+    /** The detector input of one frame: the rectified sample of a channel, or
+        the maximum or mean of those of all channels.
+    */
+    template <typename PCMType, LevelCalculationType levelType, ChannelLinkMode link>
+    juce::int32 getKey(const PCMType* const* inputs, size_t channel, size_t index) const noexcept;
+
+    //==============================================================================
+    /** The envelopes in Q1.63, see MyFixedPoint. */
+    std::vector<juce::int64> state;
+    std::vector<juce::int32> minimumGain;
+    size_t numChannels = 0;
+
+    LevelCalculationType levelType = LevelCalculationType::peak;
+    ChannelLinkMode linkMode = ChannelLinkMode::none;
+
+    // Q32.32
+    juce::int64 cteAT = 0, cteRL = 0;
+
+    /** 1 / numChannels in Q1.31 for the mean link, as an int64 so that 1 fits. */
+    juce::int64 channelScale = (juce::int64)1 << MyFixedPoint::audioFractionalBits;
+
+    /** The threshold as the peak and the RMS detector measure it, in Q1.31.
+        A ratio of 1, or a threshold at or above full scale, never reduces the
+        gain and sets them to the largest value, which no envelope exceeds.
+    */
+    juce::int32 peakThreshold = std::numeric_limits<juce::int32>::max();
+    juce::int32 meanSquareThreshold = std::numeric_limits<juce::int32>::max();
+
+    /** log2 of the peak threshold in Q8.24, and the slope 1 / ratio - 1 in
+        Q2.30, each also for a mean square: twice the log2, half the slope.
+    */
+    juce::int32 log2Threshold = 0, meanSquareLog2Threshold = 0;
+    juce::int32 slope = 0, meanSquareSlope = 0;
+};
@@ -0,0 +1,121 @@
+#include <JuceHeader.h>
+#include "MyLookahead.h"
+
+//==============================================================================
+template <typename SampleType>
+void MyLookahead<SampleType>::prepare(const juce::dsp::ProcessSpec& spec, int maximumDelaySamples)
+{
+    jassert(spec.numChannels > 0);
+    jassert(maximumDelaySamples >= 0);
+
+    const auto numChannels = (size_t)spec.numChannels;
+    instructionSet = MyCpuDispatch::getInstructionSet();
+
+    maximumDelay = juce::jmax(0, maximumDelaySamples);
+    maximumBlockSize = (size_t)juce::jmax(1, (int)spec.maximumBlockSize);
+
+    // A whole block is written before the delayed block is read back, so the
+    // ring needs room for both
+    delayBufferSize = (size_t)maximumDelay + maximumBlockSize;
+    delayBuffer.assign(numChannels * delayBufferSize, static_cast<SampleType> (0.0));
+    writePositions.assign(numChannels, 0);
+
+    // A window of D + 1 samples never holds more than D + 1 entries
+    const auto windowCapacity = (size_t)juce::nextPowerOfTwo(maximumDelay + 1);
+    windowMask = windowCapacity - 1;
+    windowValues.assign(numChannels * windowCapacity, static_cast<SampleType> (0.0));
+    windowIndices.assign(numChannels * windowCapacity, 0);
+    windows.assign(numChannels, PeakWindow());
+
+    setDelay(delay);
+}
+
+template <typename SampleType>
+void MyLookahead<SampleType>::reset() noexcept
+{
+    std::fill(delayBuffer.begin(), delayBuffer.end(), static_cast<SampleType> (0.0));
+    std::fill(writePositions.begin(), writePositions.end(), 0);
+    std::fill(windows.begin(), windows.end(), PeakWindow());
+}
+
+template <typename SampleType>
+void MyLookahead<SampleType>::setDelay(int newDelaySamples) noexcept
+{
+    jassert(newDelaySamples >= 0);
+    delay = juce::jlimit(0, maximumDelay, newDelaySamples);
+}
+
+//==============================================================================
+template <typename SampleType>
+void MyLookahead<SampleType>::processPeak(size_t channel, const SampleType* input, SampleType* peak, size_t numSamples) noexcept
+{
+    MyCpuDispatch::call(instructionSet, [&] { processPeakKernel(channel, input, peak, numSamples); });
+}
+
+template <typename SampleType>
+void MyLookahead<SampleType>::processDelay(size_t channel, const SampleType* input, SampleType* output, size_t numSamples) noexcept
+{
+    MyCpuDispatch::call(instructionSet, [&] { processDelayKernel(channel, input, output, numSamples); });
+}
+
+template <typename SampleType>
+void MyLookahead<SampleType>::processPeakKernel(size_t channel, const SampleType* input, SampleType* peak, size_t numSamples) noexcept
+{
+    jassert(channel < windows.size());
+
+    auto* values = windowValues.data() + channel * (windowMask + 1);
+    auto* indices = windowIndices.data() + channel * (windowMask + 1);
+    auto w = windows[channel];
+
+    const auto windowLength = (size_t)delay + 1;
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        const auto value = std::abs(input[i]);
+
+        // Drop what has left the window before pushing, so that the deque
+        // never holds more than D + 1 entries. This normally pops at most one
+        // entry, more only right after the delay was shortened.
+        while (w.front != w.back && indices[w.front & windowMask] + windowLength <= w.sampleIndex)
+            ++w.front;
+
+        // Older entries that are not larger can never be the maximum again
+        while (w.back != w.front && values[(w.back - 1) & windowMask] <= value)
+            --w.back;
+
+        values[w.back & windowMask] = value;
+        indices[w.back & windowMask] = w.sampleIndex;
+        ++w.back;
+
+        peak[i] = values[w.front & windowMask];
+        ++w.sampleIndex;
+    }
+
+    windows[channel] = w;
+}
+
+template <typename SampleType>
+void MyLookahead<SampleType>::processDelayKernel(size_t channel, const SampleType* input, SampleType* output, size_t numSamples) noexcept
+{
+    jassert(channel < writePositions.size());
+    jassert(numSamples <= maximumBlockSize);
+
+    auto* ring = delayBuffer.data() + channel * delayBufferSize;
+    const auto writePosition = writePositions[channel];
+
+    // Write the whole block first, so that input and output may alias
+    const auto numToEnd = juce::jmin(numSamples, delayBufferSize - writePosition);
+    std::copy(input, input + numToEnd, ring + writePosition);
+    std::copy(input + numToEnd, input + numSamples, ring);
+
+    const auto readPosition = (writePosition + delayBufferSize - (size_t)delay) % delayBufferSize;
+    const auto numToReadEnd = juce::jmin(numSamples, delayBufferSize - readPosition);
+    std::copy(ring + readPosition, ring + readPosition + numToReadEnd, output);
+    std::copy(ring, ring + (numSamples - numToReadEnd), output + numToReadEnd);
+
+    writePositions[channel] = (writePosition + numSamples) % delayBufferSize;
+}
+
+//==============================================================================
+template class MyLookahead<float>;
+template class MyLookahead<double>;
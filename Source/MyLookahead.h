@@ -0,0 +1,85 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MyCpuDispatch.h"
+
+/**
+    The lookahead stage of MyCompressor: a delay line for the audio path and a
+    sliding window maximum for the detector path.
+
+    With a delay of D samples the audio sample leaving the delay line at time n
+    is x[n - D], and the detector sees the peak of |x| over the window
+    x[n - D] ... x[n], so the envelope already reacts to a transient when the
+    transient reaches the gain stage.
+
+    The window maximum is kept in a monotonic deque: every sample is pushed and
+    popped at most once, so the cost per sample is O(1) amortised whatever the
+    window length. All storage is allocated in prepare().
+
+    @tags{DSP}
+*/
+template <typename SampleType>
+class MyLookahead
+{
+public:
+    //==============================================================================
+    /** Allocates the delay lines and deques for up to maximumDelaySamples of
+        delay. The blocks passed to the process functions must not be longer
+        than spec.maximumBlockSize. Also picks the instruction set of the
+        kernels, see MyCpuDispatch.
+    */
+    void prepare(const juce::dsp::ProcessSpec& spec, int maximumDelaySamples);
+
+    /** Clears the delay lines and deques. */
+    void reset() noexcept;
+
+    /** Sets the delay in samples, limited to the maximum given to prepare().
+        This does not allocate.
+    */
+    void setDelay(int newDelaySamples) noexcept;
+
+    /** Returns the current delay in samples. */
+    int getDelay() const noexcept { return delay; }
+
+    //==============================================================================
+    /** Writes the peak of |input| over the lookahead window ending at each
+        sample into peak. Every detector channel keeps its own window;
+        input and peak may be the same buffer.
+    */
+    void processPeak(size_t channel, const SampleType* input, SampleType* peak, size_t numSamples) noexcept;
+
+    /** Delays a block of a channel's audio by the current delay. input and
+        output may be the same buffer.
+    */
+    void processDelay(size_t channel, const SampleType* input, SampleType* output, size_t numSamples) noexcept;
+
+private:
+    //==============================================================================
+    void processPeakKernel(size_t channel, const SampleType* input, SampleType* peak, size_t numSamples) noexcept;
+    void processDelayKernel(size_t channel, const SampleType* input, SampleType* output, size_t numSamples) noexcept;
+
+    //==============================================================================
+    /** A fixed capacity deque of (sample index, value) pairs, decreasing in
+        value from front to back. The positions count up forever and are
+        masked on access.
+    */
+    struct PeakWindow
+    {
+        size_t front = 0, back = 0;
+        size_t sampleIndex = 0;
+    };
+
+    //==============================================================================
+    std::vector<SampleType> delayBuffer;
+    std::vector<size_t> writePositions;
+    size_t delayBufferSize = 0;
+
+    std::vector<SampleType> windowValues;
+    std::vector<size_t> windowIndices;
+    std::vector<PeakWindow> windows;
+    size_t windowMask = 0;
+
+    int delay = 0, maximumDelay = 0;
+    size_t maximumBlockSize = 0;
+    InstructionSet instructionSet = InstructionSet::generic;
+};
@@ -0,0 +1,284 @@
+#include <JuceHeader.h>
+#include "MyMultibandCompressor.h"
+
+//==============================================================================
+template <typename SampleType>
+void MyMultibandCompressor<SampleType>::setCoefficients(const MyMultibandCoefficients& newCoefficients) noexcept
+{
+    const auto newNumBands = juce::jlimit(1, maximumNumBands, newCoefficients.numBands);
+
+    if (newNumBands != numBands)
+    {
+        numBands = newNumBands;
+        reset();
+    }
+
+    coefficients = newCoefficients;
+    coefficients.numBands = numBands;
+
+    // Keep the splits in ascending order and below Nyquist
+    auto lowerFrequency = 10.0;
+
+    for (size_t split = 0; split < crossoverFrequencies.size(); ++split)
+    {
+        const auto frequency = juce::jlimit(lowerFrequency, sampleRate * 0.49, coefficients.crossoverFrequencies[split]);
+        lowerFrequency = frequency;
+
+        if (frequency == crossoverFrequencies[split])
+            continue;
+
+        crossoverFrequencies[split] = frequency;
+        crossovers[split].setCutoffFrequency(static_cast<SampleType> (frequency));
+
+        for (int band = 0; band < (int)split; ++band)
+            getAllpass(band, (int)split).setCutoffFrequency(static_cast<SampleType> (frequency));
+    }
+
+    updateUnitCoefficients();
+}
+
+template <typename SampleType>
+void MyMultibandCompressor<SampleType>::setPrecision(GainComputerPrecision newPrecision) noexcept
+{
+    precision = newPrecision;
+}
+
+template <typename SampleType>
+void MyMultibandCompressor<SampleType>::setLevelCalculationType(BallisticsFilterLevelCalculationType newType) noexcept
+{
+    if (levelType != newType)
+    {
+        levelType = newType;
+        std::fill(states.begin(), states.end(), static_cast<SampleType> (0.0));
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void MyMultibandCompressor<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.sampleRate > 0);
+    jassert(spec.numChannels > 0);
+
+    sampleRate = spec.sampleRate;
+    numChannels = (int)spec.numChannels;
+
+    for (auto& crossover : crossovers)
+    {
+        crossover.setType(Crossover::Type::lowpass);
+        crossover.prepare(spec);
+    }
+
+    for (auto& allpass : allpasses)
+    {
+        allpass.setType(Crossover::Type::allpass);
+        allpass.prepare(spec);
+    }
+
+    // Room for the maximum number of bands, so changing it never allocates
+    const auto lanes = SIMDType::size();
+    const auto maximumNumUnits = ((spec.numChannels * (size_t)maximumNumBands + lanes - 1) / lanes) * lanes;
+
+    bandBuffer.assign(maximumNumUnits * kernelBlockSize, static_cast<SampleType> (0.0));
+
+    for (auto* values : { &states, &attackCoefficients, &releaseCoefficients,
+                          &thresholdsdB, &ratioInverses, &log2Thresholds, &slopes })
+        values->assign(maximumNumUnits, static_cast<SampleType> (0.0));
+
+    // Force every crossover frequency to be set
+    crossoverFrequencies.fill(0.0);
+    setCoefficients(coefficients);
+
+    reset();
+}
+
+template <typename SampleType>
+void MyMultibandCompressor<SampleType>::reset() noexcept
+{
+    for (auto& crossover : crossovers)
+        crossover.reset();
+
+    for (auto& allpass : allpasses)
+        allpass.reset();
+
+    std::fill(states.begin(), states.end(), static_cast<SampleType> (0.0));
+}
+
+//==============================================================================
+template <typename SampleType>
+typename MyMultibandCompressor<SampleType>::Crossover& MyMultibandCompressor<SampleType>::getAllpass(int band, int split) noexcept
+{
+    jassert(band < split && split < maximumNumBands - 1);
+    return allpasses[(size_t)(split * (split - 1) / 2 + band)];
+}
+
+template <typename SampleType>
+void MyMultibandCompressor<SampleType>::updateUnitCoefficients() noexcept
+{
+    const auto lanes = SIMDType::size();
+    numUnits = (((size_t)numChannels * (size_t)numBands + lanes - 1) / lanes) * lanes;
+
+    for (size_t unit = 0; unit < states.size(); ++unit)
+    {
+        const auto isUsed = unit < (size_t)(numChannels * numBands);
+        const auto& band = coefficients.bands[unit % (size_t)numBands];
+
+        // Padding units get a unity gain: a slope of zero and a 0 dB ratio
+        attackCoefficients[unit] = isUsed ? static_cast<SampleType> (band.cteAT) : static_cast<SampleType> (0.0);
+        releaseCoefficients[unit] = isUsed ? static_cast<SampleType> (band.cteRL) : static_cast<SampleType> (0.0);
+        thresholdsdB[unit] = isUsed ? static_cast<SampleType> (band.parameters.thresholddB) : static_cast<SampleType> (0.0);
+        ratioInverses[unit] = isUsed ? static_cast<SampleType> (band.ratioInverse) : static_cast<SampleType> (1.0);
+        log2Thresholds[unit] = isUsed ? static_cast<SampleType> (band.log2Threshold) : static_cast<SampleType> (0.0);
+        slopes[unit] = isUsed ? static_cast<SampleType> (band.slope) : static_cast<SampleType> (0.0);
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+void MyMultibandCompressor<SampleType>::splitBands(const juce::dsp::AudioBlock<const SampleType>& inputBlock) noexcept
+{
+    const auto numFrames = inputBlock.getNumSamples();
+    const auto lastSplit = numBands - 1;
+
+    for (size_t channel = 0; channel < inputBlock.getNumChannels(); ++channel)
+    {
+        const auto* input = inputBlock.getChannelPointer(channel);
+        auto* bands = bandBuffer.data() + channel * (size_t)numBands * kernelBlockSize;
+
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            auto rest = input[i];
+            meterInputPeak = juce::jmax(meterInputPeak, std::abs(rest));
+
+            // Split off the lowest remaining band, then bring it in phase with
+            // the bands above by passing it through their allpass responses
+            for (int split = 0; split < lastSplit; ++split)
+            {
+                SampleType low, high;
+                crossovers[(size_t)split].processSample((int)channel, rest, low, high);
+
+                for (int above = split + 1; above < lastSplit; ++above)
+                    low = getAllpass(split, above).processSample((int)channel, low);
+
+                bands[(size_t)split * kernelBlockSize + i] = low;
+                rest = high;
+            }
+
+            bands[(size_t)lastSplit * kernelBlockSize + i] = rest;
+        }
+    }
+}
+
+template <typename SampleType>
+void MyMultibandCompressor<SampleType>::processUnitGroup(size_t firstUnit, const juce::dsp::AudioBlock<SampleType>& outputBlock) noexcept
+{
+    constexpr auto lanes = SIMDType::size();
+    const auto numFrames = outputBlock.getNumSamples();
+    const auto numUsedUnits = (size_t)numBands * outputBlock.getNumChannels();
+
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, kernelBlockSize * lanes> frames{};
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, kernelBlockSize * lanes> envelope;
+
+    // Per lane coefficients
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, lanes> attack, release, state;
+    std::array<SampleType, lanes> thrdB, ratioInv, log2Thr, slopeValue;
+
+    const auto offset = (std::ptrdiff_t)firstUnit;
+    std::copy_n(attackCoefficients.begin() + offset, lanes, attack.begin());
+    std::copy_n(releaseCoefficients.begin() + offset, lanes, release.begin());
+    std::copy_n(states.begin() + offset, lanes, state.begin());
+    std::copy_n(thresholdsdB.begin() + offset, lanes, thrdB.begin());
+    std::copy_n(ratioInverses.begin() + offset, lanes, ratioInv.begin());
+    std::copy_n(log2Thresholds.begin() + offset, lanes, log2Thr.begin());
+    std::copy_n(slopes.begin() + offset, lanes, slopeValue.begin());
+
+    const auto numLanes = juce::jmin(lanes, numUsedUnits - juce::jmin(numUsedUnits, firstUnit));
+
+    for (size_t lane = 0; lane < numLanes; ++lane)
+        for (size_t i = 0; i < numFrames; ++i)
+            frames[i * lanes + lane] = bandBuffer[(firstUnit + lane) * kernelBlockSize + i];
+
+    // Ballistics, with the attack/release selection done per lane
+    const auto isRMS = levelType != BallisticsFilterLevelCalculationType::peak;
+    const auto attackVector = SIMDType::fromRawArray(attack.data());
+    const auto releaseVector = SIMDType::fromRawArray(release.data());
+    auto stateVector = SIMDType::fromRawArray(state.data());
+    auto envelopePeak = SIMDType::expand(static_cast<SampleType> (0.0));
+
+    for (size_t i = 0; i < numFrames * lanes; i += lanes)
+    {
+        auto level = SIMDType::fromRawArray(frames.data() + i);
+        level = isRMS ? level * level : SIMDType::abs(level);
+
+        const auto isAttack = SIMDType::greaterThan(level, stateVector);
+        const auto cte = (attackVector & isAttack) + (releaseVector & ~isAttack);
+
+        stateVector = level + cte * (stateVector - level);
+        stateVector.copyToRawArray(envelope.data() + i);
+        envelopePeak = SIMDType::max(envelopePeak, stateVector);
+    }
+
+    stateVector.copyToRawArray(state.data());
+    std::copy(state.begin(), state.end(), states.begin() + offset);
+
+    // Gain computer, the same static curve as MyCompressor. The fast version
+    // takes a mean square as it is, see MyCompressor::computeGain().
+    if (precision == GainComputerPrecision::fast)
+    {
+        const auto scale = isRMS ? static_cast<SampleType> (2.0) : static_cast<SampleType> (1.0);
+
+        for (size_t lane = 0; lane < lanes; ++lane)
+        {
+            log2Thr[lane] *= scale;
+            slopeValue[lane] /= scale;
+        }
+
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            for (size_t lane = 0; lane < lanes; ++lane)
+            {
+                const auto overshoot = MyFastMath<SampleType>::positivePart(MyFastMath<SampleType>::log2(envelope[i * lanes + lane]) - log2Thr[lane]);
+                envelope[i * lanes + lane] = MyFastMath<SampleType>::exp2(overshoot * slopeValue[lane]);
+            }
+        }
+    }
+    else
+    {
+        const auto minusInf = static_cast<SampleType> (-200.0);
+
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            for (size_t lane = 0; lane < lanes; ++lane)
+            {
+                auto level = envelope[i * lanes + lane];
+                level = isRMS ? std::sqrt(level) : level;
+
+                const auto env = juce::Decibels::gainToDecibels(level, minusInf);
+                const auto y = (env < thrdB[lane]) ? env : thrdB[lane] + ((env - thrdB[lane]) * ratioInv[lane]);
+                envelope[i * lanes + lane] = juce::Decibels::decibelsToGain(y - env, minusInf);
+            }
+        }
+    }
+
+    // VCA, summing the bands back into their channels
+    for (size_t lane = 0; lane < numLanes; ++lane)
+    {
+        const auto env = envelopePeak.get(lane);
+        meterEnvelopePeak = juce::jmax(meterEnvelopePeak, isRMS ? std::sqrt(env) : env);
+
+        const auto unit = firstUnit + lane;
+        auto* output = outputBlock.getChannelPointer(unit / (size_t)numBands);
+        const auto* band = bandBuffer.data() + unit * kernelBlockSize;
+
+        for (size_t i = 0; i < numFrames; ++i)
+        {
+            const auto gain = envelope[i * lanes + lane];
+            output[i] += band[i] * gain;
+            meterMinimumGain = juce::jmin(meterMinimumGain, gain);
+        }
+    }
+}
+
+//==============================================================================
+template class MyMultibandCompressor<float>;
+template class MyMultibandCompressor<double>;
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MyCompressor.h"
+
+/** A complete set of coefficients for MyMultibandCompressor: the band layout
+    and one MyCompressorCoefficients snapshot per band.
+*/
+struct MyMultibandCoefficients
+{
+    static constexpr int maximumNumBands = 5;
+
+    /** The number of bands in use, from 1 to maximumNumBands. */
+    int numBands = 1;
+
+    /** The crossover frequencies in Hz between band i and band i + 1. */
+    std::array<double, maximumNumBands - 1> crossoverFrequencies{ 120.0, 1000.0, 4000.0, 10000.0 };
+
+    std::array<MyCompressorCoefficients, maximumNumBands> bands;
+};
+
+/**
+    A multiband compressor: a Linkwitz-Riley crossover splits every channel
+    into 2 to 5 bands, each band is compressed with its own settings and the
+    bands are summed again.
+
+    The crossover is a cascade of 4th order Linkwitz-Riley splits. Every band
+    below the last split also goes through the allpass responses of the splits
+    above it, so with all gains at unity the bands sum to an allpass filtered
+    copy of the input with a flat magnitude response.
+
+    The detectors and gain computers of all bands of all channels are packed
+    into SIMD lanes, structure-of-arrays style, with per lane coefficients:
+    stereo with 4 bands is 8 lanes, so two float registers on SSE or a single
+    one on AVX. All memory is allocated in prepare().
+
+    Peak and RMS detection are supported; windowed RMS is treated as RMS.
+    There is no lookahead and no threshold or ratio ramping, new coefficients
+    apply from the start of the next block.
+
+    @tags{DSP}
+*/
+template <typename SampleType>
+class MyMultibandCompressor
+{
+public:
+    //==============================================================================
+    static constexpr int maximumNumBands = MyMultibandCoefficients::maximumNumBands;
+
+    //==============================================================================
+    /** Applies a band layout and the settings of every band.
+
+        The crossover filters are only recalculated when a frequency changes and
+        are cleared when the number of bands changes. Nothing is allocated, so
+        this can be called on the audio thread.
+    */
+    void setCoefficients(const MyMultibandCoefficients& newCoefficients) noexcept;
+
+    /** Returns the number of bands in use. */
+    int getNumBands() const noexcept { return numBands; }
+
+    /** Sets the gain computer precision, see MyCompressor::setPrecision(). */
+    void setPrecision(GainComputerPrecision newPrecision) noexcept;
+
+    /** Sets how the detectors measure the level (peak or RMS). */
+    void setLevelCalculationType(BallisticsFilterLevelCalculationType newType) noexcept;
+
+    //==============================================================================
+    /** Initialises the processor for up to maximumNumBands bands. */
+    void prepare(const juce::dsp::ProcessSpec& spec);
+
+    /** Resets the crossover and detector states. */
+    void reset() noexcept;
+
+    //==============================================================================
+    /** Processes the input and output samples supplied in the processing context. */
+    template <typename ProcessContext>
+    void process(const ProcessContext& context) noexcept
+    {
+        const auto& inputBlock = context.getInputBlock();
+        auto& outputBlock = context.getOutputBlock();
+        const auto numSamples = outputBlock.getNumSamples();
+
+        jassert(inputBlock.getNumChannels() == outputBlock.getNumChannels());
+        jassert(outputBlock.getNumChannels() <= (size_t)numChannels);
+        jassert(inputBlock.getNumSamples() == numSamples);
+
+        meterInputPeak = meterEnvelopePeak = static_cast<SampleType> (0.0);
+        meterMinimumGain = static_cast<SampleType> (1.0);
+        meterValues = MyCompressorMeterValues();
+
+        if (context.isBypassed)
+        {
+            if (inputBlock.getChannelPointer(0) != outputBlock.getChannelPointer(0))
+                outputBlock.copyFrom(inputBlock);
+
+            return;
+        }
+
+        for (size_t start = 0; start < numSamples; start += kernelBlockSize)
+        {
+            const auto numFrames = juce::jmin(kernelBlockSize, numSamples - start);
+
+            // The whole chunk is split before anything is written to the
+            // output, so the input and output may be the same buffer
+            splitBands(inputBlock.getSubBlock(start, numFrames));
+            outputBlock.getSubBlock(start, numFrames).clear();
+
+            for (size_t firstUnit = 0; firstUnit < numUnits; firstUnit += SIMDType::size())
+                processUnitGroup(firstUnit, outputBlock.getSubBlock(start, numFrames));
+        }
+
+        meterValues.inputPeak = static_cast<float> (meterInputPeak);
+        meterValues.envelopePeak = static_cast<float> (meterEnvelopePeak);
+        meterValues.minimumGain = static_cast<float> (meterMinimumGain);
+    }
+
+    /** Returns the levels measured during the last call to process(), with the
+        envelope and gain of the band with the most gain reduction.
+    */
+    MyCompressorMeterValues getMeterValues() const noexcept { return meterValues; }
+
+private:
+    //==============================================================================
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
+    using Crossover = juce::dsp::LinkwitzRileyFilter<SampleType>;
+
+    static constexpr size_t kernelBlockSize = 64;
+
+    /** Writes the bands of every channel of a chunk to bandBuffer. */
+    void splitBands(const juce::dsp::AudioBlock<const SampleType>& inputBlock) noexcept;
+
+    /** Compresses SIMDType::size() units, one per lane, and adds them to the
+        channels of the output they belong to.
+    */
+    void processUnitGroup(size_t firstUnit, const juce::dsp::AudioBlock<SampleType>& outputBlock) noexcept;
+
+    /** The allpass that compensates the band of split 'band' for split 'split'. */
+    Crossover& getAllpass(int band, int split) noexcept;
+
+    void updateUnitCoefficients() noexcept;
+
+    //==============================================================================
+    // A unit is one band of one channel, unit = channel * numBands + band. All
+    // per unit arrays are padded to a whole number of SIMD registers; padding
+    // units have neutral coefficients and silent input.
+    std::vector<SampleType> bandBuffer;     // kernelBlockSize samples per unit
+    std::vector<SampleType> states;
+    std::vector<SampleType> attackCoefficients, releaseCoefficients;
+    std::vector<SampleType> thresholdsdB, ratioInverses, log2Thresholds, slopes;
+
+    std::array<Crossover, maximumNumBands - 1> crossovers;
+    std::array<Crossover, (maximumNumBands - 1) * (maximumNumBands - 2) / 2> allpasses;
+
+    MyMultibandCoefficients coefficients;
+    std::array<double, maximumNumBands - 1> crossoverFrequencies{};
+
+    double sampleRate = 44100.0;
+    int numChannels = 0, numBands = 1;
+    size_t numUnits = 0;
+
+    GainComputerPrecision precision = GainComputerPrecision::exact;
+    BallisticsFilterLevelCalculationType levelType = BallisticsFilterLevelCalculationType::peak;
+
+    SampleType meterInputPeak = 0.0, meterEnvelopePeak = 0.0, meterMinimumGain = 1.0;
+    MyCompressorMeterValues meterValues;
+};
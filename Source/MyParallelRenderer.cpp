@@ -0,0 +1,173 @@
+#include <thread>
+#include <JuceHeader.h>
+#include "MyParallelRenderer.h"
+
+//==============================================================================
+template <typename SampleType>
+juce::String MyParallelRenderer<SampleType>::Result::toString() const
+{
+    return juce::String(numChunks) + " chunks of " + juce::String(chunkSize) + " samples, warm-up "
+         + juce::String(warmUpSamples) + " samples, " + juce::String(numThreads) + " threads, "
+         + juce::String(seconds, 3) + " s";
+}
+
+//==============================================================================
+template <typename SampleType>
+void MyParallelRenderer<SampleType>::prepareCompressor(MyCompressor<SampleType>& compressor, const Settings& settings, size_t numChannels)
+{
+    compressor.prepare({ settings.sampleRate, (juce::uint32)settings.blockSize, (juce::uint32)numChannels });
+    compressor.setCoefficients(settings.coefficients);
+    compressor.setPrecision(settings.precision);
+    compressor.setLinkMode(settings.linkMode);
+    compressor.setLevelCalculationType(settings.levelType);
+    compressor.reset();
+}
+
+template <typename SampleType>
+void MyParallelRenderer<SampleType>::processBlocks(MyCompressor<SampleType>& compressor, const Settings& settings,
+                                                   const juce::dsp::AudioBlock<SampleType>& block) noexcept
+{
+    const auto blockSize = (size_t)settings.blockSize;
+
+    for (size_t start = 0; start < block.getNumSamples(); start += blockSize)
+    {
+        auto subBlock = block.getSubBlock(start, juce::jmin(blockSize, block.getNumSamples() - start));
+        compressor.process(juce::dsp::ProcessContextReplacing<SampleType>(subBlock));
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+typename MyParallelRenderer<SampleType>::Result MyParallelRenderer<SampleType>::render(const Settings& settings, int numChannels, juce::int64 numSamples,
+                                                                                       const Reader& reader, const Writer& writer)
+{
+    jassert(settings.blockSize > 0 && settings.blockSize % (int)MyCompressorCoefficients::maximumControlRateFactor == 0);
+    jassert(numChannels > 0 && numSamples >= 0);
+
+    const auto startTime = juce::Time::getMillisecondCounterHiRes();
+    auto writerSeconds = 0.0;
+
+    auto write = [&](const juce::dsp::AudioBlock<const SampleType>& output)
+    {
+        const auto writeStart = juce::Time::getMillisecondCounterHiRes();
+        const auto succeeded = writer(output);
+        writerSeconds += (juce::Time::getMillisecondCounterHiRes() - writeStart) * 0.001;
+        return succeeded;
+    };
+
+    // The key never exceeds the input peak, or the sum of the channels with
+    // the weighted link, whose weights all start at 1
+    auto keyPeak = settings.inputPeak;
+
+    if (settings.linkMode == ChannelLinkMode::weighted)
+        keyPeak *= (double)numChannels;
+
+    Result result;
+    result.warmUpSamples = settings.coefficients.calculateWarmUpSamples(settings.levelType, keyPeak, settings.maximumErrordB);
+
+    // Chunks start on block boundaries, so that every chunk is cut into the
+    // same blocks as in a serial render
+    const auto blockSize = (juce::int64)settings.blockSize;
+    const auto minimumChunkSize = juce::jmax((juce::int64)settings.minimumChunkSize, 8 * (juce::int64)result.warmUpSamples);
+    const auto chunkSize = (minimumChunkSize + blockSize - 1) / blockSize * blockSize;
+    const auto windowFits = chunkSize + result.warmUpSamples <= (juce::int64)std::numeric_limits<int>::max();
+    const auto numChunks = result.warmUpSamples < 0 || ! windowFits ? (juce::int64)1
+                                                                    : juce::jmax((juce::int64)1, (numSamples + chunkSize - 1) / chunkSize);
+
+    result.numChunks = (int)juce::jmin(numChunks, (juce::int64)std::numeric_limits<int>::max());
+    result.chunkSize = (int)juce::jmin(chunkSize, numSamples, (juce::int64)std::numeric_limits<int>::max());
+
+    if (numChunks == 1)
+    {
+        MyCompressor<SampleType> compressor;
+        prepareCompressor(compressor, settings, (size_t)numChannels);
+
+        // One block at a time, so nothing but a block is held
+        juce::AudioBuffer<SampleType> window(numChannels, settings.blockSize);
+
+        for (juce::int64 position = 0; position < numSamples; position += blockSize)
+        {
+            auto block = juce::dsp::AudioBlock<SampleType>(window).getSubBlock(0, (size_t)juce::jmin(blockSize, numSamples - position));
+
+            reader(position, block);
+            compressor.process(juce::dsp::ProcessContextReplacing<SampleType>(block));
+
+            if (! write(block))
+                break;
+        }
+
+        result.seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001 - writerSeconds;
+        result.warmUpSamples = 0;
+        return result;
+    }
+
+    // Each round reads one window (a chunk and the warm-up before it) per
+    // thread, processes them side by side and writes the chunks in order. The
+    // reader and the writer stay on this thread, and at most numThreads
+    // windows are held at a time.
+    const auto warmUpSamples = (juce::int64)result.warmUpSamples;
+    const auto numThreads = (juce::int64)juce::jmin(numChunks, (juce::int64)(settings.numThreads > 0 ? settings.numThreads
+                                                                                                  : juce::SystemStats::getNumCpus()));
+
+    struct Window
+    {
+        juce::AudioBuffer<SampleType> buffer;
+        size_t warmUpLength = 0, chunkLength = 0;
+    };
+
+    std::vector<Window> windows((size_t)numThreads);
+    std::vector<MyCompressor<SampleType>> compressors((size_t)numThreads);
+    auto isWriting = true;
+
+    for (juce::int64 firstChunk = 0; firstChunk < numChunks && isWriting; firstChunk += numThreads)
+    {
+        const auto numRoundChunks = juce::jmin(numThreads, numChunks - firstChunk);
+
+        for (juce::int64 i = 0; i < numRoundChunks; ++i)
+        {
+            const auto start = (firstChunk + i) * chunkSize;
+            auto& window = windows[(size_t)i];
+
+            window.warmUpLength = (size_t)juce::jmin(warmUpSamples, start);
+            window.chunkLength = (size_t)juce::jmin(chunkSize, numSamples - start);
+            window.buffer.setSize(numChannels, (int)(window.warmUpLength + window.chunkLength), false, false, true);
+
+            reader(start - (juce::int64)window.warmUpLength, juce::dsp::AudioBlock<SampleType>(window.buffer));
+        }
+
+        std::vector<std::thread> workers;
+
+        for (juce::int64 i = 0; i < numRoundChunks; ++i)
+        {
+            workers.emplace_back([&settings, &window = windows[(size_t)i], &compressor = compressors[(size_t)i], numChannels]
+            {
+                prepareCompressor(compressor, settings, (size_t)numChannels);
+
+                const auto block = juce::dsp::AudioBlock<SampleType>(window.buffer);
+
+                if (window.warmUpLength > 0)
+                    processBlocks(compressor, settings, block.getSubBlock(0, window.warmUpLength));
+
+                processBlocks(compressor, settings, block.getSubBlock(window.warmUpLength, window.chunkLength));
+            });
+        }
+
+        for (auto& worker : workers)
+            worker.join();
+
+        for (juce::int64 i = 0; i < numRoundChunks && isWriting; ++i)
+        {
+            auto& window = windows[(size_t)i];
+            isWriting = write(juce::dsp::AudioBlock<SampleType>(window.buffer).getSubBlock(window.warmUpLength, window.chunkLength));
+        }
+    }
+
+    result.numThreads = (int)numThreads;
+    result.seconds = (juce::Time::getMillisecondCounterHiRes() - startTime) * 0.001 - writerSeconds;
+
+    return result;
+}
+
+//==============================================================================
+template class MyParallelRenderer<float>;
+template class MyParallelRenderer<double>;
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MyCompressor.h"
+
+/**
+    Renders one long signal through MyCompressor on several cores.
+
+    A single file is one serial detector recurrence, so file level parallelism
+    does not help with a long recording. Here the signal is cut into chunks
+    that are processed side by side, each by a compressor of its own. Every
+    chunk but the first starts with a warm-up: the samples before it are
+    processed and their output thrown away, which brings the detector, the key
+    filter and the lookahead to the state a serial render has at that point
+    (see MyCompressorCoefficients::calculateWarmUpSamples()). The gain then
+    stays within Settings::maximumErrordB of a serial render, and the output
+    sample within the same ratio of the input sample.
+
+    The chunk layout depends only on the settings and the signal, never on the
+    number of threads, so a render gives the same output on every machine.
+
+    The signal is read and written through callbacks, a window at a time, so
+    memory use does not depend on its length: each thread holds one chunk and
+    its warm-up, and the chunks are written in order after every round of
+    one chunk per thread.
+
+    @tags{DSP}
+*/
+template <typename SampleType>
+class MyParallelRenderer
+{
+public:
+    //==============================================================================
+    struct Settings
+    {
+        MyCompressorCoefficients coefficients;
+        GainComputerPrecision precision = GainComputerPrecision::exact;
+        ChannelLinkMode linkMode = ChannelLinkMode::none;
+        BallisticsFilterLevelCalculationType levelType = BallisticsFilterLevelCalculationType::peak;
+        double sampleRate = 44100.0;
+
+        /** The largest gain difference from a serial render. */
+        double maximumErrordB = 0.001;
+
+        /** The largest absolute input sample, which bounds the detector key
+            and with it the warm-up. 1 covers any signal within full scale.
+        */
+        double inputPeak = 1.0;
+
+        /** The shortest chunk. Chunks are also kept at least 8 warm-ups long,
+            so the warm-up costs at most an eighth of the work.
+        */
+        int minimumChunkSize = 1 << 20;
+
+        /** The size of the blocks handed to MyCompressor::process(), a
+            multiple of MyCompressorCoefficients::maximumControlRateFactor.
+            A serial render in blocks of this size is what the result is
+            compared against.
+        */
+        int blockSize = 65536;
+
+        /** 0 for one thread per core. */
+        int numThreads = 0;
+    };
+
+    struct Result
+    {
+        int numChunks = 1, numThreads = 1;
+        int chunkSize = 0, warmUpSamples = 0;
+
+        /** The wall clock time of the render, including the reads but not the
+            time spent in the writer.
+        */
+        double seconds = 0.0;
+
+        /** A one line summary, for a log. */
+        juce::String toString() const;
+    };
+
+    /** Fills a block with the input that starts at a position of the signal.
+        Only called from the thread that called render().
+    */
+    using Reader = std::function<void (juce::int64 position, const juce::dsp::AudioBlock<SampleType>& destination)>;
+
+    /** Receives the next part of the output, in order. Returns false to stop
+        the render. Only called from the thread that called render().
+    */
+    using Writer = std::function<bool (const juce::dsp::AudioBlock<const SampleType>& output)>;
+
+    //==============================================================================
+    /** Renders numSamples samples of numChannels channels, exactly as a
+        freshly prepared compressor would with process(): the output is
+        delayed by the lookahead. Returns early if the writer fails.
+
+        Falls back to a serial render when the signal is too short to split,
+        the detector never forgets its past (see
+        MyCompressorCoefficients::calculateWarmUpSamples()), or a chunk and its
+        warm-up would not fit in an AudioBuffer.
+    */
+    static Result render(const Settings& settings, int numChannels, juce::int64 numSamples,
+                         const Reader& reader, const Writer& writer);
+
+    //==============================================================================
+    /** Prepares a compressor with the settings, as render() does for every chunk. */
+    static void prepareCompressor(MyCompressor<SampleType>& compressor, const Settings& settings, size_t numChannels);
+
+    /** Processes a block in blocks of Settings::blockSize. A compressor from
+        prepareCompressor() fed the whole signal this way is the serial render
+        that render() is compared against.
+    */
+    static void processBlocks(MyCompressor<SampleType>& compressor, const Settings& settings,
+                              const juce::dsp::AudioBlock<SampleType>& block) noexcept;
+};
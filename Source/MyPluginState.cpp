@@ -0,0 +1,161 @@
+#include <JuceHeader.h>
+#include "MyPluginState.h"
+
+namespace
+{
+    // "MyCs", little-endian
+    constexpr int stateMagic = 0x7343794d;
+
+    // The magic, the version and the size of the values that follow
+    constexpr size_t headerSize = 8;
+
+    // 8 floats and 9 bytes for the compressor, then the crossovers and 4
+    // floats per band
+    constexpr size_t version1Size = 8 * 4 + 9 + (MyMultibandCoefficients::maximumNumBands - 1) * 4
+                                  + MyMultibandCoefficients::maximumNumBands * 4 * 4;
+}
+
+//==============================================================================
+void MyPluginState::writeTo(juce::MemoryBlock& destData) const
+{
+    juce::MemoryOutputStream values;
+
+    for (auto value : { thresholddB, ratio, attackTime, releaseTime, lookaheadTime, rmsWindowTime, keyFrequency, keyQ })
+        values.writeFloat(value);
+
+    for (auto value : { rcMode, (int)keyFilter, (int)controlRate, (int)precision, (int)levelType, (int)linkMode,
+                        (int)bypass, (int)externalKey, numBands })
+        values.writeByte((char)value);
+
+    for (auto frequency : crossoverFrequencies)
+        values.writeFloat(frequency);
+
+    for (auto& band : bands)
+        for (auto value : { band.thresholddB, band.ratio, band.attackTime, band.releaseTime })
+            values.writeFloat(value);
+
+    jassert(values.getDataSize() == version1Size);
+
+    juce::MemoryOutputStream output(destData, false);
+    output.writeInt(stateMagic);
+    output.writeShort((short)currentVersion);
+    output.writeShort((short)values.getDataSize());
+    output.write(values.getData(), values.getDataSize());
+}
+
+bool MyPluginState::readFrom(const void* data, size_t sizeInBytes) noexcept
+{
+    if (data == nullptr || sizeInBytes < headerSize)
+        return false;
+
+    // Reads straight from the host's memory, nothing is copied
+    juce::MemoryInputStream input(data, sizeInBytes, false);
+
+    if (input.readInt() != stateMagic)
+        return false;
+
+    const auto version = (int)(juce::uint16)input.readShort();
+    const auto valuesSize = (size_t)(juce::uint16)input.readShort();
+
+    if (version < 1 || valuesSize < version1Size || valuesSize > sizeInBytes - headerSize)
+        return false;
+
+    // Read into a copy, so that a state with invalid values changes nothing
+    auto state = *this;
+    auto isValid = true;
+
+    auto readFloat = [&input, &isValid]
+    {
+        const auto value = input.readFloat();
+        isValid = isValid && std::isfinite(value);
+        return value;
+    };
+
+    auto readChoice = [&input](int numChoices)
+    {
+        return juce::jlimit(0, numChoices - 1, (int)(juce::uint8)input.readByte());
+    };
+
+    for (auto* value : { &state.thresholddB, &state.ratio, &state.attackTime, &state.releaseTime,
+                         &state.lookaheadTime, &state.rmsWindowTime, &state.keyFrequency, &state.keyQ })
+        *value = readFloat();
+
+    state.rcMode = readChoice(3);
+    state.keyFilter = static_cast<SidechainFilterType>(readChoice(3));
+    state.controlRate = readChoice(2) != 0;
+    state.precision = static_cast<GainComputerPrecision>(readChoice(2));
+    state.levelType = static_cast<BallisticsFilterLevelCalculationType>(readChoice(3));
+    state.linkMode = static_cast<ChannelLinkMode>(readChoice(4));
+    state.bypass = readChoice(2) != 0;
+    state.externalKey = readChoice(2) != 0;
+    state.numBands = juce::jlimit(1, MyMultibandCoefficients::maximumNumBands, (int)(juce::uint8)input.readByte());
+
+    for (auto& frequency : state.crossoverFrequencies)
+        frequency = readFloat();
+
+    for (auto& band : state.bands)
+        for (auto* value : { &band.thresholddB, &band.ratio, &band.attackTime, &band.releaseTime })
+            *value = readFloat();
+
+    // Values appended by later versions are skipped
+
+    if (! isValid)
+        return false;
+
+    *this = state;
+    return true;
+}
+
+//==============================================================================
+MyCompressorParameters MyPluginState::getCompressorParameters() const noexcept
+{
+    MyCompressorParameters parameters;
+    parameters.thresholddB = thresholddB;
+    parameters.ratio = ratio;
+    parameters.attackTime = attackTime;
+    parameters.releaseTime = releaseTime;
+    parameters.lookaheadTime = lookaheadTime;
+    parameters.rmsWindowTime = rmsWindowTime;
+    parameters.rcMode = rcMode;
+    parameters.sidechainFilterType = keyFilter;
+    parameters.sidechainFilterFrequency = keyFrequency;
+    parameters.sidechainFilterQ = keyQ;
+    parameters.controlRate = controlRate;
+
+    return parameters;
+}
+
+MyCompressorParameters MyPluginState::getBandParameters(int band) const noexcept
+{
+    jassert(juce::isPositiveAndBelow(band, MyMultibandCoefficients::maximumNumBands));
+
+    // The RC mode and the control rate are shared with the single band mode
+    MyCompressorParameters parameters;
+    parameters.thresholddB = bands[(size_t)band].thresholddB;
+    parameters.ratio = bands[(size_t)band].ratio;
+    parameters.attackTime = bands[(size_t)band].attackTime;
+    parameters.releaseTime = bands[(size_t)band].releaseTime;
+    parameters.rcMode = rcMode;
+    parameters.controlRate = controlRate;
+
+    return parameters;
+}
+
+MyCompressorCoefficients MyPluginState::calculateCoefficients(double sampleRate) const noexcept
+{
+    return MyCompressorCoefficients::calculate(getCompressorParameters(), sampleRate);
+}
+
+MyMultibandCoefficients MyPluginState::calculateMultibandCoefficients(double sampleRate) const noexcept
+{
+    MyMultibandCoefficients coefficients;
+    coefficients.numBands = numBands;
+
+    for (size_t split = 0; split < crossoverFrequencies.size(); ++split)
+        coefficients.crossoverFrequencies[split] = crossoverFrequencies[split];
+
+    for (int band = 0; band < MyMultibandCoefficients::maximumNumBands; ++band)
+        coefficients.bands[(size_t)band] = MyCompressorCoefficients::calculate(getBandParameters(band), sampleRate);
+
+    return coefficients;
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MyCompressor.h"
+#include "MyMultibandCompressor.h"
+
+/**
+    Everything the plugin saves with a session, as plain values, and its
+    compact binary form.
+
+    The binary form is a small header followed by the values in a fixed
+    order: floats for the continuous parameters and single bytes for the
+    choices and switches, about 150 bytes in all. Compared with the XML of a
+    ValueTree there is nothing to parse and no string to look up, which
+    matters when a session holds hundreds of instances.
+
+    Later versions only append values. An older state read by a newer build
+    keeps the defaults for the values it does not have, and a newer state read
+    by an older build has its extra values skipped.
+
+    @tags{DSP}
+*/
+struct MyPluginState
+{
+    //==============================================================================
+    /** The version written by writeTo(). */
+    static constexpr int currentVersion = 1;
+
+    /** Writes the binary form, replacing the contents of destData. */
+    void writeTo(juce::MemoryBlock& destData) const;
+
+    /** Reads a binary form written by writeTo(). Returns false, leaving the
+        state untouched, if the data is not a state or is truncated.
+    */
+    bool readFrom(const void* data, size_t sizeInBytes) noexcept;
+
+    //==============================================================================
+    /** The settings of the single band compressor. */
+    MyCompressorParameters getCompressorParameters() const noexcept;
+
+    /** The settings of one band of the multiband mode. */
+    MyCompressorParameters getBandParameters(int band) const noexcept;
+
+    /** Computes the coefficient snapshots of both engines. */
+    MyCompressorCoefficients calculateCoefficients(double sampleRate) const noexcept;
+    MyMultibandCoefficients calculateMultibandCoefficients(double sampleRate) const noexcept;
+
+    //==============================================================================
+    // The defaults are those of the plugin's parameter layout
+    float thresholddB = 0.0f, ratio = 4.0f, attackTime = 5.0f, releaseTime = 200.0f;
+    float lookaheadTime = 0.0f, rmsWindowTime = 300.0f;
+    float keyFrequency = 100.0f, keyQ = 0.71f;
+
+    int rcMode = 0;
+    SidechainFilterType keyFilter = SidechainFilterType::off;
+    bool controlRate = false;
+
+    GainComputerPrecision precision = GainComputerPrecision::exact;
+    BallisticsFilterLevelCalculationType levelType = BallisticsFilterLevelCalculationType::peak;
+    ChannelLinkMode linkMode = ChannelLinkMode::none;
+    bool bypass = false, externalKey = false;
+
+    struct Band
+    {
+        float thresholddB = 0.0f, ratio = 4.0f, attackTime = 5.0f, releaseTime = 200.0f;
+    };
+
+    int numBands = 1;
+    std::array<float, MyMultibandCoefficients::maximumNumBands - 1> crossoverFrequencies{ 120.0f, 1000.0f, 4000.0f, 10000.0f };
+    std::array<Band, MyMultibandCoefficients::maximumNumBands> bands;
+};
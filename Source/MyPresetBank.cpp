@@ -0,0 +1,63 @@
+#include <JuceHeader.h>
+#include "MyPresetBank.h"
+
+//==============================================================================
+juce::String MyPresetBank::getSlotName(int slot)
+{
+    jassert(juce::isPositiveAndBelow(slot, numSlots));
+    return juce::String::charToString((juce::juce_wchar)('A' + slot));
+}
+
+//==============================================================================
+void MyPresetBank::store(int slot, const MyPluginState& state) noexcept
+{
+    jassert(juce::isPositiveAndBelow(slot, numSlots));
+
+    auto& preset = presets[(size_t)slot];
+    preset.state = state;
+    preset.isStored = true;
+
+    publish(slot);
+}
+
+void MyPresetBank::setSampleRate(double newSampleRate) noexcept
+{
+    if (newSampleRate == sampleRate)
+        return;
+
+    sampleRate = newSampleRate;
+
+    for (int slot = 0; slot < numSlots; ++slot)
+        if (presets[(size_t)slot].isStored)
+            publish(slot);
+}
+
+const MyPreset& MyPresetBank::getPreset(int slot) const noexcept
+{
+    jassert(juce::isPositiveAndBelow(slot, numSlots));
+    return presets[(size_t)slot];
+}
+
+void MyPresetBank::publish(int slot) noexcept
+{
+    auto& preset = presets[(size_t)slot];
+    preset.coefficients = preset.state.calculateCoefficients(sampleRate);
+    preset.multibandCoefficients = preset.state.calculateMultibandCoefficients(sampleRate);
+
+    auto& snapshot = snapshots[(size_t)slot];
+    snapshot.getWriteBuffer() = preset;
+    snapshot.publish();
+}
+
+//==============================================================================
+const MyPreset* MyPresetBank::recall(int slot) noexcept
+{
+    if (! juce::isPositiveAndBelow(slot, numSlots))
+        return nullptr;
+
+    auto& snapshot = snapshots[(size_t)slot];
+    snapshot.pull();
+
+    const auto& preset = snapshot.getReadBuffer();
+    return preset.isStored ? &preset : nullptr;
+}
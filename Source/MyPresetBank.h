@@ -0,0 +1,70 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MyPluginState.h"
+#include "MyTripleBuffer.h"
+
+/** A stored preset with the coefficient snapshots of both engines, computed
+    when it was stored.
+*/
+struct MyPreset
+{
+    MyPluginState state;
+    MyCompressorCoefficients coefficients;
+    MyMultibandCoefficients multibandCoefficients;
+
+    /** False for a slot nothing was stored in. */
+    bool isStored = false;
+};
+
+/**
+    A fixed number of presets held in memory, for A/B comparisons and quick
+    recall.
+
+    store() computes the coefficient snapshots of a preset on the message
+    thread and hands them to the audio thread through a MyTripleBuffer per
+    slot. recall() on the audio thread then only picks up a pointer: it
+    neither allocates nor computes anything, so switching presets costs the
+    same as any other snapshot change.
+
+    Like MyTripleBuffer this has a single writer and a single reader. The
+    writer side (store(), setSampleRate(), getPreset()) must be serialised
+    by the caller; recall() belongs to the audio thread.
+
+    @tags{DSP}
+*/
+class MyPresetBank
+{
+public:
+    //==============================================================================
+    static constexpr int numSlots = 8;
+
+    /** Returns "A", "B", ... */
+    static juce::String getSlotName(int slot);
+
+    //==============================================================================
+    /** Stores a state in a slot and computes its snapshots at the sample
+        rate last given to setSampleRate().
+    */
+    void store(int slot, const MyPluginState& state) noexcept;
+
+    /** Recomputes the snapshots of every stored slot for a new sample rate. */
+    void setSampleRate(double newSampleRate) noexcept;
+
+    /** Returns a slot as last stored, for the writer side. */
+    const MyPreset& getPreset(int slot) const noexcept;
+
+    //==============================================================================
+    /** Returns the latest snapshots of a slot, or nullptr if nothing was
+        stored in it. For the audio thread.
+    */
+    const MyPreset* recall(int slot) noexcept;
+
+private:
+    //==============================================================================
+    void publish(int slot) noexcept;
+
+    std::array<MyPreset, numSlots> presets;
+    std::array<MyTripleBuffer<MyPreset>, numSlots> snapshots;
+    double sampleRate = 44100.0;
+};
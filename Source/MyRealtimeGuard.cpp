@@ -0,0 +1,151 @@
+#include <JuceHeader.h>
+#include "MyRealtimeGuard.h"
+
+#if MY_REALTIME_GUARD
+
+#include <cstdlib>
+#include <new>
+
+//==============================================================================
+namespace
+{
+    thread_local int realtimeDepth = 0;
+    std::atomic<int> numViolations{ 0 };
+}
+
+MyRealtimeGuard::ScopedRealtimeSection::ScopedRealtimeSection() noexcept  { ++realtimeDepth; }
+MyRealtimeGuard::ScopedRealtimeSection::~ScopedRealtimeSection() noexcept { --realtimeDepth; }
+
+void MyRealtimeGuard::checkNotRealtime() noexcept
+{
+    if (realtimeDepth == 0)
+        return;
+
+    numViolations.fetch_add(1, std::memory_order_relaxed);
+
+    if (juce::juce_isRunningUnderDebugger())
+        JUCE_BREAK_IN_DEBUGGER;
+}
+
+int MyRealtimeGuard::getNumViolations() noexcept
+{
+    return numViolations.load(std::memory_order_relaxed);
+}
+
+//==============================================================================
+namespace
+{
+    void* allocate(std::size_t size) noexcept
+    {
+        MyRealtimeGuard::checkNotRealtime();
+        return std::malloc(size == 0 ? 1 : size);
+    }
+
+    void deallocate(void* memory) noexcept
+    {
+        if (memory != nullptr)
+            MyRealtimeGuard::checkNotRealtime();
+
+        std::free(memory);
+    }
+
+    // The aligned forms need their own allocator: the default library ones
+    // do not call the replaced unaligned forms, so they would go unchecked
+    void* allocateAligned(std::size_t size, std::align_val_t alignment) noexcept
+    {
+        MyRealtimeGuard::checkNotRealtime();
+
+        const auto align = juce::jmax((std::size_t)alignment, sizeof(void*));
+
+       #if JUCE_WINDOWS
+        return _aligned_malloc(size == 0 ? 1 : size, align);
+       #else
+        // aligned_alloc wants the size to be a multiple of the alignment
+        return std::aligned_alloc(align, ((size == 0 ? 1 : size) + align - 1) / align * align);
+       #endif
+    }
+
+    void deallocateAligned(void* memory) noexcept
+    {
+        if (memory != nullptr)
+            MyRealtimeGuard::checkNotRealtime();
+
+       #if JUCE_WINDOWS
+        _aligned_free(memory);
+       #else
+        std::free(memory);
+       #endif
+    }
+}
+
+//==============================================================================
+// Every replaceable form is replaced, so that none of them bypasses the check
+void* operator new(std::size_t size)
+{
+    if (auto* memory = allocate(size))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    if (auto* memory = allocateAligned(size, alignment))
+        return memory;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return allocateAligned(size, alignment);
+}
+
+//==============================================================================
+void operator delete(void* memory) noexcept                                             { deallocate(memory); }
+void operator delete[](void* memory) noexcept                                           { deallocate(memory); }
+void operator delete(void* memory, std::size_t) noexcept                                { deallocate(memory); }
+void operator delete[](void* memory, std::size_t) noexcept                              { deallocate(memory); }
+void operator delete(void* memory, const std::nothrow_t&) noexcept                      { deallocate(memory); }
+void operator delete[](void* memory, const std::nothrow_t&) noexcept                    { deallocate(memory); }
+
+void operator delete(void* memory, std::align_val_t) noexcept                           { deallocateAligned(memory); }
+void operator delete[](void* memory, std::align_val_t) noexcept                         { deallocateAligned(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept              { deallocateAligned(memory); }
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept            { deallocateAligned(memory); }
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept    { deallocateAligned(memory); }
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept  { deallocateAligned(memory); }
+
+#else
+
+int MyRealtimeGuard::getNumViolations() noexcept
+{
+    return 0;
+}
+
+#endif
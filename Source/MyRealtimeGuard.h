@@ -0,0 +1,80 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/** Enables the real-time checks, on by default in debug builds only. With the
+    checks enabled, MyRealtimeGuard.cpp replaces the global operator new and
+    operator delete of the binary it is linked into.
+*/
+#ifndef MY_REALTIME_GUARD
+ #define MY_REALTIME_GUARD JUCE_DEBUG
+#endif
+
+/**
+    Debug checks for code that must be real-time safe.
+
+    A ScopedRealtimeSection marks the current thread as real-time while it
+    exists. Heap allocations, heap frees and MyCheckedLock acquisitions made
+    inside such a section are counted as violations, and break into the
+    debugger if one is attached. Nothing is logged from inside the section
+    since that would allocate in turn: read getNumViolations() elsewhere.
+
+    With MY_REALTIME_GUARD off every part of this compiles to nothing.
+
+    @tags{DSP}
+*/
+struct MyRealtimeGuard
+{
+    /** Marks the calling thread as real-time for the lifetime of the object.
+        Sections may be nested.
+    */
+    struct ScopedRealtimeSection
+    {
+       #if MY_REALTIME_GUARD
+        ScopedRealtimeSection() noexcept;
+        ~ScopedRealtimeSection() noexcept;
+       #else
+        ScopedRealtimeSection() = default;
+       #endif
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeSection)
+    };
+
+    /** Records a violation if the calling thread is inside a real-time section. */
+   #if MY_REALTIME_GUARD
+    static void checkNotRealtime() noexcept;
+   #else
+    static void checkNotRealtime() noexcept {}
+   #endif
+
+    /** Returns the number of violations recorded since the program started,
+        always 0 with MY_REALTIME_GUARD off.
+    */
+    static int getNumViolations() noexcept;
+};
+
+/**
+    A lock that counts as a violation when it is taken inside a
+    MyRealtimeGuard::ScopedRealtimeSection, for example
+    MyCheckedLock<juce::SpinLock> in place of a juce::SpinLock.
+
+    @tags{DSP}
+*/
+template <typename LockType>
+class MyCheckedLock  : public LockType
+{
+public:
+    void enter() const noexcept
+    {
+        MyRealtimeGuard::checkNotRealtime();
+        LockType::enter();
+    }
+
+    bool tryEnter() const noexcept
+    {
+        MyRealtimeGuard::checkNotRealtime();
+        return LockType::tryEnter();
+    }
+
+    using ScopedLockType = juce::GenericScopedLock<MyCheckedLock>;
+};
@@ -0,0 +1,132 @@
+#include <JuceHeader.h>
+#include "MySidechainFilter.h"
+
+// See MyCompressor.cpp: the kernel is compiled for several instruction sets,
+// and without contraction all of them round the same way
+#if JUCE_GCC
+ #pragma GCC optimize ("fp-contract=off")
+#elif JUCE_CLANG
+ #pragma STDC FP_CONTRACT OFF
+#endif
+
+//==============================================================================
+template <typename SampleType>
+void MySidechainFilter<SampleType>::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    jassert(spec.numChannels > 0);
+
+    instructionSet = MyCpuDispatch::getInstructionSet();
+
+    const auto lanes = SIMDType::size();
+    const auto numPaddedChannels = ((spec.numChannels + lanes - 1) / lanes) * lanes;
+
+    state1.assign(numPaddedChannels, static_cast<SampleType> (0.0));
+    state2.assign(numPaddedChannels, static_cast<SampleType> (0.0));
+}
+
+template <typename SampleType>
+void MySidechainFilter<SampleType>::reset() noexcept
+{
+    std::fill(state1.begin(), state1.end(), static_cast<SampleType> (0.0));
+    std::fill(state2.begin(), state2.end(), static_cast<SampleType> (0.0));
+}
+
+template <typename SampleType>
+void MySidechainFilter<SampleType>::setCoefficients(const MyCompressorCoefficients& newCoefficients) noexcept
+{
+    const auto newType = newCoefficients.parameters.sidechainFilterType;
+
+    if (newType != type)
+    {
+        type = newType;
+        reset();
+    }
+
+    const auto& c = newCoefficients.sidechainFilter;
+
+    b0 = static_cast<SampleType> (c[0]);
+    b1 = static_cast<SampleType> (c[1]);
+    b2 = static_cast<SampleType> (c[2]);
+    a1 = static_cast<SampleType> (c[3]);
+    a2 = static_cast<SampleType> (c[4]);
+}
+
+template <typename SampleType>
+bool MySidechainFilter<SampleType>::isSilent(SampleType level) const noexcept
+{
+    for (size_t channel = 0; channel < state1.size(); ++channel)
+        if (std::abs(state1[channel]) > level || std::abs(state2[channel]) > level)
+            return false;
+
+    return true;
+}
+
+//==============================================================================
+template <typename SampleType>
+void MySidechainFilter<SampleType>::processLanes(size_t firstChannel, SampleType* frames, size_t numFrames) noexcept
+{
+    MyCpuDispatch::call(instructionSet, [&] { processLanesKernel(firstChannel, frames, numFrames); });
+}
+
+template <typename SampleType>
+void MySidechainFilter<SampleType>::processLanesKernel(size_t firstChannel, SampleType* frames, size_t numFrames) noexcept
+{
+    constexpr auto lanes = SIMDType::size();
+
+    jassert(firstChannel % lanes == 0 && firstChannel + lanes <= state1.size());
+    jassert(SIMDType::isSIMDAligned(frames));
+
+    alignas (SIMDType::SIMDRegisterSize) std::array<SampleType, lanes> s1, s2;
+    std::copy_n(state1.begin() + (std::ptrdiff_t)firstChannel, lanes, s1.begin());
+    std::copy_n(state2.begin() + (std::ptrdiff_t)firstChannel, lanes, s2.begin());
+
+    auto z1 = SIMDType::fromRawArray(s1.data());
+    auto z2 = SIMDType::fromRawArray(s2.data());
+
+    const auto vb0 = SIMDType::expand(b0), vb1 = SIMDType::expand(b1), vb2 = SIMDType::expand(b2);
+    const auto va1 = SIMDType::expand(a1), va2 = SIMDType::expand(a2);
+
+    for (size_t i = 0; i < numFrames * lanes; i += lanes)
+    {
+        const auto x = SIMDType::fromRawArray(frames + i);
+        const auto y = vb0 * x + z1;
+
+        z1 = vb1 * x - va1 * y + z2;
+        z2 = vb2 * x - va2 * y;
+
+        y.copyToRawArray(frames + i);
+    }
+
+    z1.copyToRawArray(s1.data());
+    z2.copyToRawArray(s2.data());
+
+    // A high-passed key decays towards zero through the denormal range
+    for (size_t lane = 0; lane < lanes; ++lane)
+    {
+        juce::dsp::util::snapToZero(s1[lane]);
+        juce::dsp::util::snapToZero(s2[lane]);
+    }
+
+    std::copy(s1.begin(), s1.end(), state1.begin() + (std::ptrdiff_t)firstChannel);
+    std::copy(s2.begin(), s2.end(), state2.begin() + (std::ptrdiff_t)firstChannel);
+}
+
+template <typename SampleType>
+SampleType MySidechainFilter<SampleType>::processSample(size_t channel, SampleType inputValue) noexcept
+{
+    jassert(channel < state1.size());
+
+    auto& z1 = state1[channel];
+    auto& z2 = state2[channel];
+
+    const auto y = b0 * inputValue + z1;
+
+    z1 = b1 * inputValue - a1 * y + z2;
+    z2 = b2 * inputValue - a2 * y;
+
+    return y;
+}
+
+//==============================================================================
+template class MySidechainFilter<float>;
+template class MySidechainFilter<double>;
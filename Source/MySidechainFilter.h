@@ -0,0 +1,69 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "MyCompressorCoefficients.h"
+#include "MyCpuDispatch.h"
+
+/**
+    The optional key filter of MyCompressor: one biquad, high-pass or
+    band-pass, shared by all channels of the detector path.
+
+    The filter is a transposed direct form II and runs on the interleaved
+    sample frames of the compressor kernel, one channel per SIMD lane, so a
+    stereo or surround key costs about as much as a mono one. The coefficients
+    come precomputed from MyCompressorCoefficients, so changing them is safe on
+    the audio thread. All storage is allocated in prepare().
+
+    @tags{DSP}
+*/
+template <typename SampleType>
+class MySidechainFilter
+{
+public:
+    //==============================================================================
+    using SIMDType = juce::dsp::SIMDRegister<SampleType>;
+
+    //==============================================================================
+    /** Allocates the state for spec.numChannels channels, and picks the
+        instruction set of the kernel, see MyCpuDispatch.
+    */
+    void prepare(const juce::dsp::ProcessSpec& spec);
+
+    /** Clears the filter state. */
+    void reset() noexcept;
+
+    /** Applies the filter type and coefficients of a snapshot. The state is
+        cleared when the type changes.
+    */
+    void setCoefficients(const MyCompressorCoefficients& newCoefficients) noexcept;
+
+    /** Returns true unless the filter type is SidechainFilterType::off. */
+    bool isEnabled() const noexcept { return type != SidechainFilterType::off; }
+
+    /** Returns true if the state of every channel is within level of zero, so
+        that a silent input gives an output of about that size.
+    */
+    bool isSilent(SampleType level) const noexcept;
+
+    //==============================================================================
+    /** Filters numFrames interleaved sample frames of the SIMDType::size()
+        channels starting at firstChannel, which must be a multiple of
+        SIMDType::size(), in place.
+    */
+    void processLanes(size_t firstChannel, SampleType* frames, size_t numFrames) noexcept;
+
+    /** Filters one sample of one channel. */
+    SampleType processSample(size_t channel, SampleType inputValue) noexcept;
+
+private:
+    //==============================================================================
+    void processLanesKernel(size_t firstChannel, SampleType* frames, size_t numFrames) noexcept;
+
+    //==============================================================================
+    // Two state variables per channel, padded to a whole number of registers
+    std::vector<SampleType> state1, state2;
+
+    SidechainFilterType type = SidechainFilterType::off;
+    SampleType b0 = 1.0, b1 = 0.0, b2 = 0.0, a1 = 0.0, a2 = 0.0;
+    InstructionSet instructionSet = InstructionSet::generic;
+};
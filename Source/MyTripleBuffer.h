@@ -0,0 +1,54 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    A wait-free triple buffer for handing a value from one writer thread to one
+    reader thread, typically from the message thread to the audio thread.
+
+    The writer fills getWriteBuffer() and calls publish(); the reader calls
+    pull(), which returns the latest published value or nullptr if nothing
+    changed since the previous call. Both sides exchange a single atomic index
+    and never block or allocate. If several threads may write, they must
+    serialise among themselves.
+
+    @tags{DSP}
+*/
+template <typename ValueType>
+class MyTripleBuffer
+{
+public:
+    //==============================================================================
+    /** Returns the slot the writer should fill before calling publish(). */
+    ValueType& getWriteBuffer() noexcept { return buffers[(size_t)writeIndex]; }
+
+    /** Makes the contents of getWriteBuffer() visible to the reader. */
+    void publish() noexcept
+    {
+        writeIndex = middle.exchange(writeIndex | dirtyBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    //==============================================================================
+    /** Returns the most recently published value, or nullptr if no new value has
+        been published since the last call.
+    */
+    const ValueType* pull() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & dirtyBit) == 0)
+            return nullptr;
+
+        readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask;
+        return &buffers[(size_t)readIndex];
+    }
+
+    /** Returns the value last returned by pull(). */
+    const ValueType& getReadBuffer() const noexcept { return buffers[(size_t)readIndex]; }
+
+private:
+    //==============================================================================
+    static constexpr int indexMask = 3, dirtyBit = 4;
+
+    std::array<ValueType, 3> buffers{};
+    std::atomic<int> middle{ 1 };
+    int writeIndex = 0, readIndex = 2;
+};
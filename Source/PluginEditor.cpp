@@ -9,17 +9,199 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+//==============================================================================
+void GainReductionMeter::setGainReduction (float newGainReductiondB)
+{
+    gainReductiondB = juce::jlimit (0.0f, rangedB, newGainReductiondB);
+
+    const auto newBarHeight = juce::roundToInt ((float)getHeight() * gainReductiondB / rangedB);
+
+    if (newBarHeight != barHeight)
+    {
+        // Only the strip between the old and the new end of the bar changes
+        repaint (0, juce::jmin (barHeight, newBarHeight), getWidth(), std::abs (newBarHeight - barHeight));
+        barHeight = newBarHeight;
+    }
+}
+
+void GainReductionMeter::paint (juce::Graphics& g)
+{
+    g.fillAll (juce::Colours::black);
+
+    g.setColour (juce::Colours::orange);
+    g.fillRect (0, 0, getWidth(), barHeight);
+}
+
+//==============================================================================
+void GainReductionHistory::push (float gainReductiondB)
+{
+    if (! image.isValid())
+        return;
+
+    const auto height = image.getHeight();
+    const auto y = juce::roundToInt ((float)height * juce::jlimit (0.0f, 1.0f, gainReductiondB / GainReductionMeter::rangedB));
+
+    // Draw the new column over the oldest one
+    {
+        juce::Graphics g (image);
+        g.setColour (juce::Colours::black);
+        g.fillRect (writeColumn, 0, 1, height);
+        g.setColour (juce::Colours::orange);
+        g.fillRect (writeColumn, 0, 1, y);
+    }
+
+    writeColumn = (writeColumn + 1) % image.getWidth();
+    repaint();
+}
+
+void GainReductionHistory::paint (juce::Graphics& g)
+{
+    if (! image.isValid())
+        return;
+
+    // The oldest column is at writeColumn: draw from there to the end of the
+    // image on the left, then the start of the image up to it on the right
+    const auto width = image.getWidth();
+    const auto height = image.getHeight();
+
+    g.drawImage (image, 0, 0, width - writeColumn, height, writeColumn, 0, width - writeColumn, height);
+    g.drawImage (image, width - writeColumn, 0, writeColumn, height, 0, 0, writeColumn, height);
+}
+
+void GainReductionHistory::resized()
+{
+    if (getWidth() <= 0 || getHeight() <= 0)
+        return;
+
+    image = juce::Image (juce::Image::RGB, getWidth(), getHeight(), true);
+    writeColumn = 0;
+}
+
+//==============================================================================
+void TransferCurve::setCurve (float newThresholddB, float newRatio)
+{
+    if (newThresholddB == thresholddB && newRatio == ratio)
+        return;
+
+    thresholddB = newThresholddB;
+    ratio = newRatio;
+
+    renderCurve();
+    repaint();
+}
+
+void TransferCurve::setOperatingPoint (float inputdB, float gaindB)
+{
+    inputdB = juce::jmax (minimumdB, inputdB);
+    const auto newDot = toPosition (inputdB, juce::jmax (minimumdB, inputdB + gaindB));
+
+    if (newDot.toInt() == dot.toInt())
+        return;
+
+    repaint (getDotArea());
+    dot = newDot;
+    repaint (getDotArea());
+}
+
+void TransferCurve::paint (juce::Graphics& g)
+{
+    g.drawImageAt (curve, 0, 0);
+
+    g.setColour (juce::Colours::orange);
+    g.fillEllipse (getDotArea().reduced (1).toFloat());
+}
+
+void TransferCurve::resized()
+{
+    renderCurve();
+}
+
+juce::Point<float> TransferCurve::toPosition (float inputdB, float outputdB) const noexcept
+{
+    const auto width = (float)getWidth();
+    const auto height = (float)getHeight();
+
+    return { juce::jmap (inputdB, minimumdB, 0.0f, 0.0f, width),
+             juce::jmap (outputdB, minimumdB, 0.0f, height, 0.0f) };
+}
+
+juce::Rectangle<int> TransferCurve::getDotArea() const noexcept
+{
+    return juce::Rectangle<float> (10.0f, 10.0f).withCentre (dot).getSmallestIntegerContainer();
+}
+
+void TransferCurve::renderCurve()
+{
+    if (getWidth() <= 0 || getHeight() <= 0)
+        return;
+
+    curve = juce::Image (juce::Image::RGB, getWidth(), getHeight(), true);
+    juce::Graphics g (curve);
+
+    g.fillAll (juce::Colours::black);
+
+    // A grid line every 12 dB
+    g.setColour (juce::Colours::darkgrey);
+
+    for (auto level = minimumdB; level < 0.0f; level += 12.0f)
+    {
+        const auto position = toPosition (level, level);
+        g.drawVerticalLine (juce::roundToInt (position.x), 0.0f, (float)getHeight());
+        g.drawHorizontalLine (juce::roundToInt (position.y), 0.0f, (float)getWidth());
+    }
+
+    // The static curve is two straight lines meeting at the threshold
+    const auto knee = juce::jlimit (minimumdB, 0.0f, thresholddB);
+
+    juce::Path path;
+    path.startNewSubPath (toPosition (minimumdB, minimumdB));
+    path.lineTo (toPosition (knee, knee));
+    path.lineTo (toPosition (0.0f, knee - knee / ratio));
+
+    g.setColour (juce::Colours::white);
+    g.strokePath (path, juce::PathStrokeType (2.0f));
+}
+
 //==============================================================================
 CompressorAudioProcessorEditor::CompressorAudioProcessorEditor (CompressorAudioProcessor& p)
-    : AudioProcessorEditor (&p), audioProcessor (p)
+    : AudioProcessorEditor (&p), audioProcessor (p), parameters (p)
 {
+    threshold = p.apvts.getParameter ("Threshold");
+    ratio = p.apvts.getParameter ("Ratio");
+
+    addAndMakeVisible (parameters);
+    addAndMakeVisible (transferCurve);
+    addAndMakeVisible (meter);
+    addAndMakeVisible (history);
+
+    statistics.setFont (juce::Font (12.0f));
+    statistics.setJustificationType (juce::Justification::topLeft);
+    addAndMakeVisible (statistics);
+
+    resetStatistics.onClick = [this] { audioProcessor.getBlockTimer().reset(); };
+    addAndMakeVisible (resetStatistics);
+
+    for (auto* button : { &presetA, &presetB })
+    {
+        const auto slot = button == &presetA ? 0 : 1;
+
+        button->setClickingTogglesState (true);
+        button->setRadioGroupId (1);
+        button->setToggleState (audioProcessor.getSelectedPreset() == slot, juce::dontSendNotification);
+        button->onClick = [this, slot] { audioProcessor.selectPreset (slot); };
+        addAndMakeVisible (*button);
+    }
+
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (800, 540);
+
+    startTimerHz (60);
 }
 
 CompressorAudioProcessorEditor::~CompressorAudioProcessorEditor()
 {
+    stopTimer();
 }
 
 //==============================================================================
@@ -27,14 +209,68 @@ void CompressorAudioProcessorEditor::paint (juce::Graphics& g)
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
     g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-
-    g.setColour (juce::Colours::white);
-    g.setFont (15.0f);
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
 }
 
 void CompressorAudioProcessorEditor::resized()
 {
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
+    auto bounds = getLocalBounds();
+
+    parameters.setBounds (bounds.removeFromLeft (400));
+
+    auto displays = bounds.reduced (10);
+
+    auto bottom = displays.removeFromBottom (40);
+    resetStatistics.setBounds (bottom.removeFromRight (60).withHeight (24));
+    presetA.setBounds (bottom.removeFromLeft (30).withHeight (24));
+    presetB.setBounds (bottom.removeFromLeft (30).withHeight (24));
+    bottom.removeFromLeft (10);
+    statistics.setBounds (bottom);
+    displays.removeFromBottom (10);
+
+    auto top = displays.removeFromTop (displays.getWidth() - 30);
+
+    meter.setBounds (top.removeFromRight (20));
+    top.removeFromRight (10);
+    transferCurve.setBounds (top);
+
+    displays.removeFromTop (10);
+    history.setBounds (displays);
+}
+
+void CompressorAudioProcessorEditor::timerCallback()
+{
+    // Every block processed since the last frame, reduced to its worst case
+    MyCompressorMeterValues values;
+    const auto numBlocks = audioProcessor.getMeterFifo().drain ([&values] (const MyCompressorMeterValues& block)
+    {
+        values.inputPeak = juce::jmax (values.inputPeak, block.inputPeak);
+        values.envelopePeak = juce::jmax (values.envelopePeak, block.envelopePeak);
+        values.minimumGain = juce::jmin (values.minimumGain, block.minimumGain);
+    });
+
+    transferCurve.setCurve (threshold->convertFrom0to1 (threshold->getValue()),
+                            ratio->convertFrom0to1 (ratio->getValue()));
+
+    // The host may switch programs too
+    presetA.setToggleState (audioProcessor.getSelectedPreset() == 0, juce::dontSendNotification);
+    presetB.setToggleState (audioProcessor.getSelectedPreset() == 1, juce::dontSendNotification);
+
+    if (--framesUntilStatistics <= 0)
+    {
+        framesUntilStatistics = 15;
+
+        const auto text = audioProcessor.getBlockTimer().getStatistics().toString()
+                        + "\nReal-time violations: " + juce::String (MyRealtimeGuard::getNumViolations());
+        statistics.setText (text, juce::dontSendNotification);
+    }
+
+    // Nothing is drawn while the processor is not running
+    if (numBlocks == 0)
+        return;
+
+    const auto gaindB = juce::Decibels::gainToDecibels (values.minimumGain, -GainReductionMeter::rangedB);
+
+    meter.setGainReduction (-gaindB);
+    history.push (-gaindB);
+    transferCurve.setOperatingPoint (juce::Decibels::gainToDecibels (values.envelopePeak, TransferCurve::minimumdB), gaindB);
 }
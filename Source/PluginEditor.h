@@ -11,10 +11,83 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 
+//==============================================================================
+/** A vertical bar showing the current gain reduction, growing downwards from
+    0 dB. Only repaints when the displayed value moves by a visible amount.
+*/
+class GainReductionMeter  : public juce::Component
+{
+public:
+    /** Sets the gain reduction in dB, as a positive number. */
+    void setGainReduction (float newGainReductiondB);
+
+    void paint (juce::Graphics&) override;
+
+    static constexpr float rangedB = 24.0f;
+
+private:
+    float gainReductiondB = 0.0f;
+    int barHeight = 0;
+};
+
+//==============================================================================
+/** A scrolling plot of the gain reduction over the last few seconds.
+
+    The plot is kept in an image used as a ring buffer of columns: every new
+    value draws a single column, and painting blits the two halves of the ring
+    in order, so the cost of a frame does not depend on the length of the
+    history.
+*/
+class GainReductionHistory  : public juce::Component
+{
+public:
+    /** Adds the gain reduction in dB of the next column. */
+    void push (float gainReductiondB);
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    juce::Image image;
+    int writeColumn = 0;
+};
+
+//==============================================================================
+/** The static input/output curve of the compressor, with a dot at the current
+    operating point.
+
+    The curve is rendered into a cached image whenever the threshold, ratio or
+    size change; between those only the areas under the old and new dot are
+    repainted.
+*/
+class TransferCurve  : public juce::Component
+{
+public:
+    void setCurve (float newThresholddB, float newRatio);
+
+    /** Moves the dot to an input level and the gain applied to it, in dB. */
+    void setOperatingPoint (float inputdB, float gaindB);
+
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+    static constexpr float minimumdB = -60.0f;
+
+private:
+    juce::Point<float> toPosition (float inputdB, float outputdB) const noexcept;
+    juce::Rectangle<int> getDotArea() const noexcept;
+    void renderCurve();
+
+    juce::Image curve;
+    float thresholddB = 0.0f, ratio = 1.0f;
+    juce::Point<float> dot;
+};
+
 //==============================================================================
 /**
 */
-class CompressorAudioProcessorEditor  : public juce::AudioProcessorEditor
+class CompressorAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                        private juce::Timer
 {
 public:
     CompressorAudioProcessorEditor (CompressorAudioProcessor&);
@@ -25,9 +98,29 @@ public:
     void resized() override;
 
 private:
+    //==============================================================================
+    /** Drains the meter queue of the processor and updates the displays. */
+    void timerCallback() override;
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     CompressorAudioProcessor& audioProcessor;
 
+    juce::GenericAudioProcessorEditor parameters;
+    GainReductionMeter meter;
+    GainReductionHistory history;
+    TransferCurve transferCurve;
+
+    // Real-time statistics, refreshed a few times per second
+    juce::Label statistics;
+    juce::TextButton resetStatistics{ "Reset" };
+    int framesUntilStatistics = 0;
+
+    // A/B comparison, the first two slots of the processor's preset bank
+    juce::TextButton presetA{ "A" }, presetB{ "B" };
+
+    juce::RangedAudioParameter* threshold{ nullptr };
+    juce::RangedAudioParameter* ratio{ nullptr };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorAudioProcessorEditor)
 };
@@ -9,6 +9,34 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+//==============================================================================
+static bool isLFE(juce::AudioChannelSet::ChannelType type)
+{
+    return type == juce::AudioChannelSet::LFE || type == juce::AudioChannelSet::LFE2;
+}
+
+// The parameters that feed the coefficient snapshot
+static const char* const coefficientParameterIDs[] = { "Threshold", "Ratio", "Attack", "Release", "Lookahead", "RMSWindow", "RCMode",
+                                                       "KeyFilter", "KeyFrequency", "KeyQ", "ControlRate" };
+
+// The per band parameters of the multiband mode are "Band1Threshold" ... "Band5Release"
+static const char* const bandParameterNames[] = { "Threshold", "Ratio", "Attack", "Release" };
+
+static juce::String getBandParameterID(int band, const char* name)
+{
+    return "Band" + juce::String(band + 1) + name;
+}
+
+static juce::String getCrossoverParameterID(int split)
+{
+    return "Crossover" + juce::String(split + 1);
+}
+
+static bool isMultibandParameter(const juce::String& parameterID)
+{
+    return parameterID.startsWith("Band") || parameterID.startsWith("Crossover");
+}
+
 //==============================================================================
 CompressorAudioProcessor::CompressorAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -16,6 +44,7 @@ CompressorAudioProcessor::CompressorAudioProcessor()
                      #if ! JucePlugin_IsMidiEffect
                       #if ! JucePlugin_IsSynth
                        .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                       .withInput  ("Sidechain", juce::AudioChannelSet::stereo(), false)
                       #endif
                        .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
                      #endif
@@ -30,14 +59,87 @@ CompressorAudioProcessor::CompressorAudioProcessor()
     jassert(threshold != nullptr);
     ratio = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("Ratio"));
     jassert(ratio != nullptr);
+    lookahead = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("Lookahead"));
+    jassert(lookahead != nullptr);
+    rmsWindow = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("RMSWindow"));
+    jassert(rmsWindow != nullptr);
     bypass = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("Bypass"));
     jassert(bypass != nullptr);
     RCMode = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("RCMode"));
     jassert(RCMode != nullptr);
+    precision = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("Precision"));
+    jassert(precision != nullptr);
+    link = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("Link"));
+    jassert(link != nullptr);
+    detector = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("Detector"));
+    jassert(detector != nullptr);
+    externalKey = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("ExternalKey"));
+    jassert(externalKey != nullptr);
+    keyFilter = dynamic_cast<juce::AudioParameterChoice*>(apvts.getParameter("KeyFilter"));
+    jassert(keyFilter != nullptr);
+    keyFrequency = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("KeyFrequency"));
+    jassert(keyFrequency != nullptr);
+    keyQ = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter("KeyQ"));
+    jassert(keyQ != nullptr);
+    controlRate = dynamic_cast<juce::AudioParameterBool*>(apvts.getParameter("ControlRate"));
+    jassert(controlRate != nullptr);
+
+    numBands = dynamic_cast<juce::AudioParameterInt*>(apvts.getParameter("Bands"));
+    jassert(numBands != nullptr);
+
+    for (int band = 0; band < MyMultibandCoefficients::maximumNumBands; ++band)
+    {
+        auto getFloatParameter = [this, band](const char* name)
+        {
+            auto* parameter = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter(getBandParameterID(band, name)));
+            jassert(parameter != nullptr);
+            return parameter;
+        };
+
+        bandParameters[(size_t)band] = { getFloatParameter("Threshold"), getFloatParameter("Ratio"),
+                                         getFloatParameter("Attack"), getFloatParameter("Release") };
+    }
+
+    for (int split = 0; split < (int)crossoverFrequencies.size(); ++split)
+    {
+        crossoverFrequencies[(size_t)split] = dynamic_cast<juce::AudioParameterFloat*>(apvts.getParameter(getCrossoverParameterID(split)));
+        jassert(crossoverFrequencies[(size_t)split] != nullptr);
+    }
+
+    for (auto* id : coefficientParameterIDs)
+        apvts.addParameterListener(id, this);
+
+    for (auto& id : getMultibandParameterIDs())
+        apvts.addParameterListener(id, this);
+
+    // Only reports the latency: the snapshots are recomputed by the audio
+    // thread, see processEngines()
+    startTimerHz(30);
 }
 
 CompressorAudioProcessor::~CompressorAudioProcessor()
 {
+    stopTimer();
+
+    for (auto* id : coefficientParameterIDs)
+        apvts.removeParameterListener(id, this);
+
+    for (auto& id : getMultibandParameterIDs())
+        apvts.removeParameterListener(id, this);
+}
+
+juce::StringArray CompressorAudioProcessor::getMultibandParameterIDs()
+{
+    juce::StringArray ids{ "Bands" };
+
+    for (int split = 0; split < MyMultibandCoefficients::maximumNumBands - 1; ++split)
+        ids.add(getCrossoverParameterID(split));
+
+    for (int band = 0; band < MyMultibandCoefficients::maximumNumBands; ++band)
+        for (auto* name : bandParameterNames)
+            ids.add(getBandParameterID(band, name));
+
+    return ids;
 }
 
 //==============================================================================
@@ -75,27 +177,51 @@ bool CompressorAudioProcessor::isMidiEffect() const
 
 double CompressorAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // The delayed audio keeps coming out for the lookahead time after the input
+    // stops, and the envelope needs its release to settle before the host may
+    // suspend us (see MyCompressor::getTailLengthSeconds()). The multiband mode
+    // has no lookahead and is as slow as its slowest band.
+    using LevelCalculationType = BallisticsFilterLevelCalculationType;
+
+    const auto mode = RCMode->getIndex();
+    const auto type = static_cast<LevelCalculationType>(detector->getIndex());
+
+    if (numBands->get() > 1)
+    {
+        // The bands treat windowed RMS as RMS
+        const auto bandType = type == LevelCalculationType::peak ? type : LevelCalculationType::RMS;
+        auto tail = 0.0;
+
+        for (int band = 0; band < numBands->get(); ++band)
+            tail = juce::jmax(tail, MyEnvelopeDetector<double>::getDecayTime(bandParameters[(size_t)band].release->get(),
+                                                                               mode, bandType, 0.0));
+
+        return tail;
+    }
+
+    return lookahead->get() * 0.001 + MyEnvelopeDetector<double>::getDecayTime(release->get(), mode, type, rmsWindow->get());
 }
 
+// The programs are the slots of the preset bank
 int CompressorAudioProcessor::getNumPrograms()
 {
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
+    return MyPresetBank::numSlots;
 }
 
 int CompressorAudioProcessor::getCurrentProgram()
 {
-    return 0;
+    return selectedPreset;
 }
 
 void CompressorAudioProcessor::setCurrentProgram (int index)
 {
+    if (juce::isPositiveAndBelow(index, MyPresetBank::numSlots))
+        selectPreset(index);
 }
 
 const juce::String CompressorAudioProcessor::getProgramName (int index)
 {
-    return {};
+    return juce::isPositiveAndBelow(index, MyPresetBank::numSlots) ? MyPresetBank::getSlotName(index) : juce::String();
 }
 
 void CompressorAudioProcessor::changeProgramName (int index, const juce::String& newName)
@@ -113,7 +239,49 @@ void CompressorAudioProcessor::prepareToPlay (double sampleRate, int samplesPerB
     spec.numChannels = getTotalNumOutputChannels();
     spec.sampleRate = sampleRate;
 
-    compressor.prepare(spec);
+    currentSampleRate = sampleRate;
+    updateLatency();
+
+    {
+        const decltype(coefficientsWriteLock)::ScopedLockType lock(coefficientsWriteLock);
+        presets.setSampleRate(sampleRate);
+    }
+
+    blockTimer.prepare(sampleRate);
+
+    if (isUsingDoublePrecision())
+        prepareEngines(doubleEngines, spec);
+    else
+        prepareEngines(floatEngines, spec);
+}
+
+template <typename SampleType>
+void CompressorAudioProcessor::prepareEngines(Engines<SampleType>& engines, const juce::dsp::ProcessSpec& spec)
+{
+    engines.compressor.prepare(spec);
+    engines.multiband.prepare(spec);
+
+    // The weighted link mode averages the main channels and ignores the LFE
+    const auto layout = getChannelLayoutOfBus(false, 0);
+    int numMainChannels = 0;
+
+    for (int channel = 0; channel < layout.size(); ++channel)
+        if (! isLFE(layout.getTypeOfChannel(channel)))
+            ++numMainChannels;
+
+    for (int channel = 0; channel < layout.size(); ++channel)
+        engines.compressor.setLinkWeight(channel, isLFE(layout.getTypeOfChannel(channel))
+                                                      ? static_cast<SampleType> (0.0)
+                                                      : static_cast<SampleType> (1.0) / (SampleType)juce::jmax(1, numMainChannels));
+
+    // Start from the current settings rather than ramping towards them. The
+    // audio thread is not running yet, so the flags can be cleared here.
+    coefficientsChanged = false;
+    multibandCoefficientsChanged = false;
+
+    const auto state = getCurrentState();
+    engines.compressor.setCoefficients(state.calculateCoefficients(spec.sampleRate));
+    engines.multiband.setCoefficients(state.calculateMultibandCoefficients(spec.sampleRate));
 }
 
 void CompressorAudioProcessor::releaseResources()
@@ -129,12 +297,10 @@ bool CompressorAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
     juce::ignoreUnused (layouts);
     return true;
   #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+    // Any layout works, from mono and stereo up to immersive formats such as
+    // 5.1 or 7.1.4: the compressor processes channels in SIMD groups or, when
+    // linked, with one shared envelope.
+    if (layouts.getMainOutputChannelSet().isDisabled())
         return false;
 
     // This checks if the input layout matches the output layout
@@ -143,13 +309,47 @@ bool CompressorAudioProcessor::isBusesLayoutSupported (const BusesLayout& layout
         return false;
    #endif
 
+    // The sidechain may be off, mono, or have no more channels than the main bus
+    if (layouts.inputBuses.size() > 1)
+    {
+        const auto sidechain = layouts.getChannelSet(true, 1);
+
+        if (! sidechain.isDisabled()
+            && sidechain != juce::AudioChannelSet::mono()
+            && sidechain.size() > layouts.getMainOutputChannelSet().size())
+            return false;
+    }
+
     return true;
   #endif
 }
 #endif
 
+bool CompressorAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
 void CompressorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    juce::ignoreUnused(midiMessages);
+    processEngines(floatEngines, buffer);
+}
+
+void CompressorAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processEngines(doubleEngines, buffer);
+}
+
+template <typename SampleType>
+void CompressorAudioProcessor::processEngines(Engines<SampleType>& engines, juce::AudioBuffer<SampleType>& buffer)
+{
+    // In debug builds anything that allocates or takes a lock in here is
+    // reported, see MyRealtimeGuard
+    const MyRealtimeGuard::ScopedRealtimeSection realtimeSection;
+    const MyBlockTimer::ScopedMeasurement measurement(blockTimer, buffer.getNumSamples());
+
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -163,24 +363,232 @@ void CompressorAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
         buffer.clear (i, 0, buffer.getNumSamples());
 
+    auto& compressor = engines.compressor;
+    auto& multiband = engines.multiband;
+
+    // A recalled preset brings its own snapshots, computed when it was stored
+    if (auto* preset = presets.recall(pendingPreset.exchange(-1)))
+    {
+        compressor.setCoefficients(preset->coefficients, buffer.getNumSamples());
+        multiband.setCoefficients(preset->multibandCoefficients);
+    }
+
+    // The snapshots are recomputed here, in the first block after a parameter
+    // changed, as calculating them neither allocates nor locks. So every block
+    // follows the parameters the host set before it, also in renders faster
+    // than real time or without a running message loop, and costs nothing
+    // extra if nothing changed. The host only reports automation once per
+    // block, so a change is ramped across the whole block instead of being
+    // applied as a step at its start.
+    const auto isCompressorOutOfDate = coefficientsChanged.exchange(false);
+    const auto isMultibandOutOfDate = multibandCoefficientsChanged.exchange(false);
+
+    if (isCompressorOutOfDate || isMultibandOutOfDate)
+    {
+        const auto state = getCurrentState();
+        const auto sampleRate = currentSampleRate.load();
+
+        if (isCompressorOutOfDate)
+            compressor.setCoefficients(state.calculateCoefficients(sampleRate), buffer.getNumSamples());
+
+        if (isMultibandOutOfDate)
+            multiband.setCoefficients(state.calculateMultibandCoefficients(sampleRate));
+    }
+
+    // The main bus is processed in place. The sidechain bus is only pointed
+    // to: the detector reads its channels where the host put them.
+    auto mainBuffer = getBusBuffer(buffer, false, 0);
+    auto block = juce::dsp::AudioBlock<SampleType>(mainBuffer);
+    auto context = juce::dsp::ProcessContextReplacing<SampleType>(block);
+
+    auto keyBlock = juce::dsp::AudioBlock<const SampleType>(block);
+
+    if (externalKey->get() && getChannelCountOfBus(true, 1) > 0)
+    {
+        auto sidechainBuffer = getBusBuffer(buffer, true, 1);
+        keyBlock = juce::dsp::AudioBlock<SampleType>(sidechainBuffer)
+                       .getSubsetChannelBlock(0, juce::jmin((size_t)sidechainBuffer.getNumChannels(), block.getNumChannels()));
+    }
 
-    compressor.setAttack(attack->get());
-    compressor.setRelease(release->get());
-    compressor.setThreshold(threshold->get());
-    compressor.setRatio(ratio->get());
+    if (bypass->get())
+        context.isBypassed = true;
 
+    compressor.setPrecision(static_cast<GainComputerPrecision>(precision->getIndex()));
+    compressor.setLinkMode(static_cast<ChannelLinkMode>(link->getIndex()));
+    compressor.setLevelCalculationType(static_cast<BallisticsFilterLevelCalculationType>(detector->getIndex()));
+    multiband.setPrecision(static_cast<GainComputerPrecision>(precision->getIndex()));
+    multiband.setLevelCalculationType(static_cast<BallisticsFilterLevelCalculationType>(detector->getIndex()));
+
+    // The multiband mode keys every band from its own signal
+    if (multiband.getNumBands() > 1)
+    {
+        multiband.process(context);
+        meterFifo.push(multiband.getMeterValues());
+    }
+    else
+    {
+        compressor.process(context, keyBlock);
+        meterFifo.push(compressor.getMeterValues());
+    }
+}
 
-    auto block = juce::dsp::AudioBlock<float>(buffer);
-    auto context = juce::dsp::ProcessContextReplacing<float>(block);
+//==============================================================================
+void CompressorAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    juce::ignoreUnused(newValue);
 
-    if (bypass->get())
-        context.isBypassed = true;
+    // Only marks the snapshots out of date for the audio thread, so applying
+    // a whole state costs a single recomputation and no concurrent change is
+    // lost. The RC mode and the control rate are shared by both engines.
+    if (! isMultibandParameter(parameterID))
+        coefficientsChanged = true;
 
-    DBG(RCMode->getParameterIndex());
-    compressor.setRCMode(RCMode->getIndex());
+    if (isMultibandParameter(parameterID) || parameterID == "RCMode" || parameterID == "ControlRate")
+        multibandCoefficientsChanged = true;
 
-    compressor.process(context);
-  
+    if (parameterID == "Lookahead" || parameterID == "Bands")
+        latencyChanged = true;
+}
+
+void CompressorAudioProcessor::timerCallback()
+{
+    if (latencyChanged.exchange(false))
+        updateLatency();
+}
+
+void CompressorAudioProcessor::updateLatency()
+{
+    // The compressor delays the audio by exactly the lookahead, so this is
+    // known before the audio thread recomputes the snapshot. The host is only
+    // notified when the value actually changes.
+    const auto lookaheadSamples = getCurrentState().calculateCoefficients(currentSampleRate.load()).lookaheadSamples;
+    setLatencySamples(numBands->get() > 1 ? 0 : lookaheadSamples);
+}
+
+//==============================================================================
+MyPluginState CompressorAudioProcessor::getCurrentState() const
+{
+    MyPluginState state;
+    state.thresholddB = threshold->get();
+    state.ratio = ratio->get();
+    state.attackTime = attack->get();
+    state.releaseTime = release->get();
+    state.lookaheadTime = lookahead->get();
+    state.rmsWindowTime = rmsWindow->get();
+    state.keyFrequency = keyFrequency->get();
+    state.keyQ = keyQ->get();
+
+    state.rcMode = RCMode->getIndex();
+    state.keyFilter = static_cast<SidechainFilterType>(keyFilter->getIndex());
+    state.controlRate = controlRate->get();
+
+    state.precision = static_cast<GainComputerPrecision>(precision->getIndex());
+    state.levelType = static_cast<BallisticsFilterLevelCalculationType>(detector->getIndex());
+    state.linkMode = static_cast<ChannelLinkMode>(link->getIndex());
+    state.bypass = bypass->get();
+    state.externalKey = externalKey->get();
+
+    state.numBands = numBands->get();
+
+    for (size_t split = 0; split < crossoverFrequencies.size(); ++split)
+        state.crossoverFrequencies[split] = crossoverFrequencies[split]->get();
+
+    for (size_t band = 0; band < bandParameters.size(); ++band)
+        state.bands[band] = { bandParameters[band].threshold->get(), bandParameters[band].ratio->get(),
+                              bandParameters[band].attack->get(), bandParameters[band].release->get() };
+
+    return state;
+}
+
+void CompressorAudioProcessor::setParameters(const MyPluginState& state)
+{
+    *threshold = state.thresholddB;
+    *ratio = state.ratio;
+    *attack = state.attackTime;
+    *release = state.releaseTime;
+    *lookahead = state.lookaheadTime;
+    *rmsWindow = state.rmsWindowTime;
+    *keyFrequency = state.keyFrequency;
+    *keyQ = state.keyQ;
+
+    *RCMode = state.rcMode;
+    *keyFilter = (int)state.keyFilter;
+    *controlRate = state.controlRate;
+
+    *precision = (int)state.precision;
+    *detector = (int)state.levelType;
+    *link = (int)state.linkMode;
+    *bypass = state.bypass;
+    *externalKey = state.externalKey;
+
+    *numBands = state.numBands;
+
+    for (size_t split = 0; split < crossoverFrequencies.size(); ++split)
+        *crossoverFrequencies[split] = state.crossoverFrequencies[split];
+
+    for (size_t band = 0; band < bandParameters.size(); ++band)
+    {
+        *bandParameters[band].threshold = state.bands[band].thresholddB;
+        *bandParameters[band].ratio = state.bands[band].ratio;
+        *bandParameters[band].attack = state.bands[band].attackTime;
+        *bandParameters[band].release = state.bands[band].releaseTime;
+    }
+}
+
+void CompressorAudioProcessor::applyState(const MyPluginState& state)
+{
+    setParameters(state);
+
+    // A recall still pending would undo the new state. The audio thread
+    // recomputes the snapshots from the parameters, which have clamped the
+    // state to their ranges.
+    pendingPreset = -1;
+    updateLatency();
+}
+
+//==============================================================================
+void CompressorAudioProcessor::storePreset(int slot)
+{
+    const decltype(coefficientsWriteLock)::ScopedLockType lock(coefficientsWriteLock);
+    presets.store(slot, getCurrentState());
+}
+
+bool CompressorAudioProcessor::recallPreset(int slot)
+{
+    MyPluginState state;
+
+    {
+        const decltype(coefficientsWriteLock)::ScopedLockType lock(coefficientsWriteLock);
+        const auto& preset = presets.getPreset(slot);
+
+        if (! preset.isStored)
+            return false;
+
+        state = preset.state;
+    }
+
+    // The audio thread takes the snapshots of the preset from the bank, and
+    // then recomputes them from the parameters as they are set, which gives
+    // the same result. Setting the parameters after the recall is requested
+    // means a change made meanwhile is never undone by the preset.
+    pendingPreset = slot;
+    setParameters(state);
+    updateLatency();
+
+    return true;
+}
+
+void CompressorAudioProcessor::selectPreset(int slot)
+{
+    if (slot == selectedPreset)
+        return;
+
+    storePreset(selectedPreset);
+
+    if (! recallPreset(slot))
+        storePreset(slot);
+
+    selectedPreset = slot;
 }
 
 //==============================================================================
@@ -191,22 +599,22 @@ bool CompressorAudioProcessor::hasEditor() const
 
 juce::AudioProcessorEditor* CompressorAudioProcessor::createEditor()
 {
-    //return new CompressorAudioProcessorEditor (*this);
-    return new juce::GenericAudioProcessorEditor(*this);
+    return new CompressorAudioProcessorEditor (*this);
 }
 
 //==============================================================================
 void CompressorAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // The compact binary form of MyPluginState. The preset bank is not saved.
+    getCurrentState().writeTo(destData);
 }
 
 void CompressorAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    MyPluginState state;
+
+    if (sizeInBytes > 0 && state.readFrom(data, (size_t)sizeInBytes))
+        applyState(state);
 }
 
 
@@ -235,6 +643,12 @@ juce::AudioProcessorValueTreeState::ParameterLayout CompressorAudioProcessor::cr
         NormalisableRange<float>(5, 500, 1, 1),
         200));
 
+    layout.add(std::make_unique<AudioParameterFloat>(
+        "Lookahead",
+        "Lookahead",
+        NormalisableRange<float>(0, (float)MyCompressorParameters::maximumLookaheadTime, 0.1f, 1),
+        0));
+
     layout.add(std::make_unique<AudioParameterFloat>(
         "Ratio",
         "Ratio",
@@ -254,6 +668,114 @@ juce::AudioProcessorValueTreeState::ParameterLayout CompressorAudioProcessor::cr
         0
     ));
 
+    layout.add(std::make_unique<AudioParameterChoice>(
+        "Precision",
+        "Precision",
+        juce::StringArray("Exact", "Fast"),
+        0
+    ));
+
+    layout.add(std::make_unique<AudioParameterChoice>(
+        "Detector",
+        "Detector",
+        juce::StringArray("Peak", "RMS", "Windowed RMS"),
+        0
+    ));
+
+    layout.add(std::make_unique<AudioParameterFloat>(
+        "RMSWindow",
+        "RMS Window",
+        NormalisableRange<float>(10, (float)MyEnvelopeDetector<float>::maximumRMSWindowTime, 1, 1),
+        300));
+
+    layout.add(std::make_unique<AudioParameterBool>(
+        "ExternalKey",
+        "External Key",
+        false
+    ));
+
+    layout.add(std::make_unique<AudioParameterChoice>(
+        "KeyFilter",
+        "Key Filter",
+        juce::StringArray("Off", "High-pass", "Band-pass"),
+        0
+    ));
+
+    {
+        NormalisableRange<float> range(20, 20000, 1);
+        range.setSkewForCentre(1000);
+
+        layout.add(std::make_unique<AudioParameterFloat>(
+            "KeyFrequency",
+            "Key Frequency",
+            range,
+            100));
+    }
+
+    layout.add(std::make_unique<AudioParameterFloat>(
+        "KeyQ",
+        "Key Q",
+        NormalisableRange<float>(0.1f, 10, 0.01f, 0.5f),
+        0.71f));
+
+    layout.add(std::make_unique<AudioParameterBool>(
+        "ControlRate",
+        "Control Rate",
+        false
+    ));
+
+    layout.add(std::make_unique<AudioParameterInt>(
+        "Bands",
+        "Bands",
+        1, MyMultibandCoefficients::maximumNumBands,
+        1));
+
+    const MyMultibandCoefficients defaultBands;
+
+    for (int split = 0; split < MyMultibandCoefficients::maximumNumBands - 1; ++split)
+    {
+        NormalisableRange<float> range(20, 20000, 1);
+        range.setSkewForCentre(1000);
+
+        layout.add(std::make_unique<AudioParameterFloat>(
+            getCrossoverParameterID(split),
+            "Crossover " + String(split + 1),
+            range,
+            (float)defaultBands.crossoverFrequencies[(size_t)split]));
+    }
+
+    for (int band = 0; band < MyMultibandCoefficients::maximumNumBands; ++band)
+    {
+        const auto name = "Band " + String(band + 1) + " ";
+
+        layout.add(std::make_unique<AudioParameterFloat>(
+            getBandParameterID(band, "Threshold"), name + "Threshold",
+            NormalisableRange<float>(-60, 12, 1, 1),
+            0));
+
+        layout.add(std::make_unique<AudioParameterFloat>(
+            getBandParameterID(band, "Ratio"), name + "Ratio",
+            NormalisableRange<float>(1, 100, 0.5, 0.2),
+            4));
+
+        layout.add(std::make_unique<AudioParameterFloat>(
+            getBandParameterID(band, "Attack"), name + "Attack",
+            NormalisableRange<float>(5, 500, 1, 1),
+            5));
+
+        layout.add(std::make_unique<AudioParameterFloat>(
+            getBandParameterID(band, "Release"), name + "Release",
+            NormalisableRange<float>(5, 500, 1, 1),
+            200));
+    }
+
+    layout.add(std::make_unique<AudioParameterChoice>(
+        "Link",
+        "Link",
+        juce::StringArray("Off", "Max", "Mean", "Weighted"),
+        0
+    ));
+
     return layout;
 }
 //==============================================================================
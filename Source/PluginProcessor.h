@@ -10,6 +10,12 @@
 
 #include <JuceHeader.h>
 #include "MyCompressor.h"
+#include "MyMultibandCompressor.h"
+#include "MyFifo.h"
+#include "MyBlockTimer.h"
+#include "MyRealtimeGuard.h"
+#include "MyPluginState.h"
+#include "MyPresetBank.h"
 
 //==============================================================================
 /**
@@ -18,6 +24,8 @@ class CompressorAudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
+                             , private juce::AudioProcessorValueTreeState::Listener
+                             , private juce::Timer
 {
 public:
     //==============================================================================
@@ -33,6 +41,8 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -61,18 +71,140 @@ public:
     static APVTS::ParameterLayout createParameterLayout();
 
     APVTS apvts{ *this, nullptr, "Parameters", createParameterLayout() };
+
+    //==============================================================================
+    /** One entry per processed block, written by the audio thread. Enough for
+        about a second of audio at 48 kHz with 256 sample blocks, so an editor
+        polling at 60 Hz never misses anything.
+    */
+    using MeterFifo = MyFifo<MyCompressorMeterValues, 256>;
+
+    /** The metering queue, to be drained by the editor on the message thread. */
+    MeterFifo& getMeterFifo() noexcept { return meterFifo; }
+
+    /** The processing time of every block, see MyBlockTimer. */
+    MyBlockTimer& getBlockTimer() noexcept { return blockTimer; }
+
+    //==============================================================================
+    /** Returns the current parameter values. */
+    MyPluginState getCurrentState() const;
+
+    /** Sets every parameter from a state. The audio thread recomputes the
+        coefficient snapshots once for the whole state, rather than once per
+        parameter.
+    */
+    void applyState(const MyPluginState& state);
+
+    /** Stores the current parameter values in a slot of the preset bank. */
+    void storePreset(int slot);
+
+    /** Recalls a slot of the preset bank: the audio thread switches to its
+        precomputed snapshots at the next block, and the parameters are set
+        to match. Returns false if nothing was stored in the slot.
+    */
+    bool recallPreset(int slot);
+
+    /** Switches the A/B comparison to another slot. The edits made in the
+        current slot are kept in it, and an empty slot starts as a copy of
+        the current one.
+    */
+    void selectPreset(int slot);
+
+    /** Returns the slot last passed to selectPreset(). */
+    int getSelectedPreset() const noexcept { return selectedPreset; }
+
 private:
-    MyCompressor<float> compressor;
-    
+    //==============================================================================
+    /** Only marks the snapshots as out of date: hosts call this on whatever
+        thread set the parameter, which may be the audio thread.
+    */
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+
+    /** Reports a changed latency to the host, on the message thread. */
+    void timerCallback() override;
+
+    /** Reports the latency of the active engine to the host. Never called on
+        the audio thread.
+    */
+    void updateLatency();
+
+    /** Sets the parameters without recomputing the snapshots for each one. */
+    void setParameters(const MyPluginState& state);
+
+    static juce::StringArray getMultibandParameterIDs();
+
+    //==============================================================================
+    /** The DSP in one sample precision. Both precisions read the same
+        coefficient snapshots; only the one the host asked for is prepared.
+    */
+    template <typename SampleType>
+    struct Engines
+    {
+        MyCompressor<SampleType> compressor;
+        MyMultibandCompressor<SampleType> multiband;
+    };
+
+    template <typename SampleType>
+    void prepareEngines(Engines<SampleType>& engines, const juce::dsp::ProcessSpec& spec);
+
+    template <typename SampleType>
+    void processEngines(Engines<SampleType>& engines, juce::AudioBuffer<SampleType>& buffer);
+
+    //==============================================================================
+    Engines<float> floatEngines;
+    Engines<double> doubleEngines;
+
+    // Set by the parameter listener, cleared when the audio thread recomputes
+    // the snapshot. The latency is reported by the timer.
+    std::atomic<bool> coefficientsChanged{ false }, multibandCoefficientsChanged{ false };
+    std::atomic<bool> latencyChanged{ false };
+
+    // The preset bank has a single writer, and prepareToPlay() may run on
+    // another thread than the editor. The audio thread never takes this lock.
+    MyCheckedLock<juce::SpinLock> coefficientsWriteLock;
+
+    // The A/B slots. A recall is picked up by the audio thread at the start of
+    // the next block.
+    MyPresetBank presets;
+    std::atomic<int> pendingPreset{ -1 };
+    int selectedPreset = 0;
+
+    std::atomic<double> currentSampleRate{ 44100.0 };
+
+    MeterFifo meterFifo;
+    MyBlockTimer blockTimer;
 
     juce::AudioParameterFloat* attack{ nullptr };
     juce::AudioParameterFloat* release{ nullptr };
     juce::AudioParameterFloat* threshold{ nullptr };
     juce::AudioParameterFloat* ratio{ nullptr };
+    juce::AudioParameterFloat* lookahead{ nullptr };
+    juce::AudioParameterFloat* rmsWindow{ nullptr };
 
     juce::AudioParameterBool* bypass{ nullptr };
+    juce::AudioParameterBool* externalKey{ nullptr };
+    juce::AudioParameterBool* controlRate{ nullptr };
 
     juce::AudioParameterChoice* RCMode{ nullptr };
+    juce::AudioParameterChoice* precision{ nullptr };
+    juce::AudioParameterChoice* link{ nullptr };
+    juce::AudioParameterChoice* detector{ nullptr };
+    juce::AudioParameterChoice* keyFilter{ nullptr };
+
+    juce::AudioParameterFloat* keyFrequency{ nullptr };
+    juce::AudioParameterFloat* keyQ{ nullptr };
+
+    struct BandParameters
+    {
+        juce::AudioParameterFloat* threshold{ nullptr };
+        juce::AudioParameterFloat* ratio{ nullptr };
+        juce::AudioParameterFloat* attack{ nullptr };
+        juce::AudioParameterFloat* release{ nullptr };
+    };
+
+    juce::AudioParameterInt* numBands{ nullptr };
+    std::array<BandParameters, MyMultibandCoefficients::maximumNumBands> bandParameters;
+    std::array<juce::AudioParameterFloat*, MyMultibandCoefficients::maximumNumBands - 1> crossoverFrequencies{};
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressorAudioProcessor)